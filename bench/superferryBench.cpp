@@ -0,0 +1,644 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// superferryBench.cpp
+// Purpose: Macro benchmark for the SuperFerry data layer (`make bench`).
+// Generates a synthetic ferry/sailing/vehicle/reservation data set in
+// the current directory, then times booking, check-in, cancellation,
+// sailing deletion (with its reservation cascade) and full report
+// rendering through ReservationService and SailingManager, plus a
+// first-page sailing search. The key scans over reservations.dat
+// (keyScan.h) are timed once per scan kernel the CPU has, each line
+// giving its speedup over the scalar loop, and random record reads are
+// timed with the page cache at its budget and turned off. With --clients N it then starts
+// `superferry serve` in a child process and times bookings and
+// check-ins sent by N concurrent socket clients.
+//
+// Every phase prints one JSON object per line (also appended to the
+// --out file): ops, ops/sec, p50/p99 latency in microseconds, and the
+// bytes the process read/wrote during the phase (/proc/self/io; -1
+// where unavailable) and the page cache hits and misses.
+//
+// Usage: superferry_bench [--records N] [--ops N] [--deletes N]
+//                         [--reports N] [--scans N] [--clients N]
+//                         [--seed N] [--out FILE]
+// Runs against whatever .dat files are in the working directory, so
+// `make bench` starts it in an empty bench_data/ directory.
+//***************************************************
+
+#include "../control/reservationServer.h"
+#include "../control/reservationService.h"
+#include "../control/sailingManager.h"
+#include "../entity/ferryASM.h"
+#include "../entity/pageCache.h"
+#include "../entity/reservationASM.h"
+#include "../entity/sailingASM.h"
+#include "../entity/storeRegistry.h"
+#include "../entity/vehicleASM.h"
+#include "../system/keyScan.h"
+#include "../system/socketChannel.h"
+#include "../system/utilities.h"
+#include "../system/writeAheadLog.h"
+#include "../system/writeBehind.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace {
+    const int FERRY_COUNT          = 50;
+    const int BOOKINGS_PER_SAILING = 20;    // generated reservations per sailing
+    const int BOOKINGS_PER_VEHICLE = 2;     // generated reservations per vehicle
+    const int CHUNK                = 65536; // records per generation batch
+    const int MAX_SAILINGS         = 26 * 26 * 26 * 31 * 24;
+
+    typedef chrono::steady_clock Clock;
+
+    //--------------------------------------
+    // Stream buffer that drops everything (report output, banners)
+    class NullBuffer : public streambuf {
+    protected:
+        int overflow(int c) { return c; }
+        streamsize xsputn(const char*, streamsize n) { return n; }
+    };
+
+    //--------------------------------------
+    // Benchmark options (command line)
+    struct Options {
+        long long records = 10000;  // generated reservations (sailings/vehicles scale with it)
+        int ops = 1000;             // timed bookings, check-ins and cancellations
+        int deletes = 10;           // timed sailing deletions
+        int reports = 3;            // timed full report renders
+        int scans = 20;             // timed key scans per kernel
+        int clients = 0;            // concurrent server clients (0 = skip the server phases)
+        unsigned seed = 42;
+        string out = "bench_results.jsonl";
+    };
+
+    //--------------------------------------
+    // Process I/O counters from /proc/self/io (-1 if unavailable)
+    struct IoCounters {
+        long long rchar = -1;       // bytes passed to read()-style syscalls
+        long long wchar = -1;       // bytes passed to write()-style syscalls
+        long long readBytes = -1;   // bytes fetched from storage
+        long long writeBytes = -1;  // bytes sent to storage
+    };
+
+    IoCounters readIo() {
+        IoCounters io;
+        ifstream in("/proc/self/io");
+        string key;
+        long long value;
+        while (in >> key >> value) {
+            if (key == "rchar:")            io.rchar = value;
+            else if (key == "wchar:")       io.wchar = value;
+            else if (key == "read_bytes:")  io.readBytes = value;
+            else if (key == "write_bytes:") io.writeBytes = value;
+        }
+        return io;
+    }
+
+    long long delta(long long before, long long after) {
+        return (before < 0 || after < 0) ? -1 : after - before;
+    }
+
+    //--------------------------------------
+    // Synthetic keys. Sailing k maps to a unique TTT-DD-HH, vehicle k
+    // to a unique plate (prefix + base-36 number).
+    string sailingId(long long k) {
+        char id[16];
+        long long terminal = k / (31 * 24);
+        snprintf(id, sizeof(id), "%c%c%c-%02d-%02d",
+                 static_cast<char>('A' + terminal / 676 % 26),
+                 static_cast<char>('A' + terminal / 26 % 26),
+                 static_cast<char>('A' + terminal % 26),
+                 static_cast<int>(k / 24 % 31 + 1),
+                 static_cast<int>(k % 24 + 1));
+        return id;
+    }
+
+    string plate(char prefix, long long k) {
+        static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        string tail;
+        do {
+            tail.insert(tail.begin(), digits[k % 36]);
+            k /= 36;
+        } while (k > 0);
+        return string(1, prefix) + tail;
+    }
+
+    string ferryName(int k) {
+        char name[NAME_LEN];
+        snprintf(name, sizeof(name), "BENCH FERRY %03d", k);
+        return name;
+    }
+
+    //--------------------------------------
+    // Latency samples of one phase -> one JSON result line
+    class Phase {
+    private:
+        string name;
+        vector<double> samples;     // microseconds per op
+        Clock::time_point started;
+        IoCounters ioBefore;
+        PageCacheStats cacheBefore;
+
+    public:
+        explicit Phase(const string& phaseName)
+            : name(phaseName), started(Clock::now()), ioBefore(readIo()), cacheBefore(PageCache::stats()) {}
+
+        template <typename Op>
+        void time(Op op) {
+            Clock::time_point t0 = Clock::now();
+            op();
+            samples.push_back(chrono::duration<double, micro>(Clock::now() - t0).count());
+        }
+
+        // For samples timed elsewhere (client threads)
+        void add(const vector<double>& timed) {
+            samples.insert(samples.end(), timed.begin(), timed.end());
+        }
+
+        double mean() const {
+            double sum = 0;
+            for (double sample : samples) sum += sample;
+            return samples.empty() ? 0.0 : sum / samples.size();
+        }
+
+        void report(const Options& opt, ostream& file, const string& extra = string()) {
+            double seconds = chrono::duration<double>(Clock::now() - started).count();
+            IoCounters ioAfter = readIo();
+            PageCacheStats cacheAfter = PageCache::stats();
+
+            vector<double> sorted(samples);
+            sort(sorted.begin(), sorted.end());
+            auto pct = [&](double p) {
+                if (sorted.empty()) return 0.0;
+                size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+                return sorted[i];
+            };
+
+            ostringstream line;
+            line.setf(ios::fixed);
+            line.precision(1);
+            line << "{\"bench\":\"" << name << "\""
+                 << ",\"records\":" << opt.records
+                 << ",\"ops\":" << samples.size()
+                 << ",\"seconds\":" << setprecision(4) << seconds << setprecision(1)
+                 << ",\"ops_per_sec\":" << (seconds > 0 ? samples.size() / seconds : 0.0)
+                 << ",\"p50_us\":" << pct(0.50)
+                 << ",\"p99_us\":" << pct(0.99)
+                 << ",\"syscall_read_bytes\":" << delta(ioBefore.rchar, ioAfter.rchar)
+                 << ",\"syscall_write_bytes\":" << delta(ioBefore.wchar, ioAfter.wchar)
+                 << ",\"storage_read_bytes\":" << delta(ioBefore.readBytes, ioAfter.readBytes)
+                 << ",\"storage_write_bytes\":" << delta(ioBefore.writeBytes, ioAfter.writeBytes)
+                 << ",\"cache_hits\":" << cacheAfter.hits - cacheBefore.hits
+                 << ",\"cache_misses\":" << cacheAfter.misses - cacheBefore.misses
+                 << extra << "}";
+            cout << line.str() << endl;
+            file << line.str() << endl;
+        }
+    };
+
+    //--------------------------------------
+    bool parseOptions(int argc, char* argv[], Options& opt) {
+        for (int i = 1; i < argc; ++i) {
+            if (i + 1 >= argc) return false;
+            string flag = argv[i];
+            const char* value = argv[++i];
+            if (flag == "--records")      opt.records = atoll(value);
+            else if (flag == "--ops")     opt.ops = atoi(value);
+            else if (flag == "--deletes") opt.deletes = atoi(value);
+            else if (flag == "--reports") opt.reports = atoi(value);
+            else if (flag == "--scans")   opt.scans = atoi(value);
+            else if (flag == "--clients") opt.clients = atoi(value);
+            else if (flag == "--seed")    opt.seed = static_cast<unsigned>(strtoul(value, nullptr, 10));
+            else if (flag == "--out")     opt.out = value;
+            else return false;
+        }
+        return opt.records > 0 && opt.ops >= 0 && opt.deletes >= 0 && opt.reports >= 0 &&
+               opt.clients >= 0 && opt.clients <= 256;
+    }
+
+    //--------------------------------------
+    // Writes the synthetic data set through the ASM batch appends.
+    // Every generated vehicle is 2.0 m x 7.0 m and books the low lane,
+    // so each sailing's LRL is reduced by 7 m per reservation.
+    long long generate(const Options& opt, SailingManager& sm) {
+        long long sailingCount = max(1LL, opt.records / BOOKINGS_PER_SAILING);
+        if (sailingCount > MAX_SAILINGS) sailingCount = MAX_SAILINGS;
+        long long vehicleCount = max(1LL, opt.records / BOOKINGS_PER_VEHICLE);
+
+        vector<Ferry> ferries(FERRY_COUNT);
+        for (int f = 0; f < FERRY_COUNT; ++f) {
+            memset(&ferries[f], 0, sizeof(Ferry));
+            strncpy(ferries[f].ferryName, ferryName(f).c_str(), sizeof(ferries[f].ferryName) - 1);
+            ferries[f].HCLL = 3600;
+            ferries[f].LCLL = 3600;
+        }
+        FerryASM::writeFerries(ferries);
+        WriteAheadLog::commit();
+
+        // reservations are dealt round-robin over the sailings
+        vector<SailingRecord> sailingChunk;
+        for (long long s = 0; s < sailingCount; ++s) {
+            SailingRecord r{};
+            strncpy(r.date, sailingId(s).c_str(), DATE_LEN - 1);
+            memcpy(r.ferryName, ferries[s % FERRY_COUNT].ferryName, NAME_LEN);
+            long long booked = opt.records / sailingCount + (s < opt.records % sailingCount ? 1 : 0);
+            r.highLaneRestDm = 36000;
+            r.lowLaneRestDm = static_cast<int>(max(0LL, 36000 - 70 * booked));
+            sailingChunk.push_back(r);
+            if (static_cast<int>(sailingChunk.size()) == CHUNK || s + 1 == sailingCount) {
+                sm.addSailings(sailingChunk);
+                WriteAheadLog::commit();
+                sailingChunk.clear();
+            }
+        }
+
+        VehicleASM& vehicles = StoreRegistry::vehicles();
+        vector<Vehicle> vehicleChunk;
+        for (long long v = 0; v < vehicleCount; ++v) {
+            Vehicle rec{};
+            strncpy(rec.licensePlate, plate('G', v).c_str(), sizeof(rec.licensePlate) - 1);
+            snprintf(rec.customerPhone, sizeof(rec.customerPhone), "604-%03lld-%04lld",
+                     v / 10000 % 1000, v % 10000);
+            rec.specialHeight = 2.0f;
+            rec.specialLength = 7.0f;
+            vehicleChunk.push_back(rec);
+            if (static_cast<int>(vehicleChunk.size()) == CHUNK || v + 1 == vehicleCount) {
+                vehicles.addRecords(vehicleChunk);
+                WriteAheadLog::commit();
+                vehicleChunk.clear();
+            }
+        }
+
+        ReservationASM& reservations = StoreRegistry::reservations();
+        vector<ReservationRecord> reservationChunk;
+        for (long long r = 0; r < opt.records; ++r) {
+            ReservationRecord rec{};
+            strncpy(rec.sailingId, sailingId(r % sailingCount).c_str(), sizeof(rec.sailingId) - 1);
+            strncpy(rec.licensePlate, plate('G', r % vehicleCount).c_str(), sizeof(rec.licensePlate) - 1);
+            rec.isOnboard = false;
+            rec.laneUsed = 'L';
+            reservationChunk.push_back(rec);
+            if (static_cast<int>(reservationChunk.size()) == CHUNK || r + 1 == opt.records) {
+                reservations.writeReservationRecords(reservationChunk);
+                WriteAheadLog::commit();
+                reservationChunk.clear();
+            }
+        }
+
+        return sailingCount;
+    }
+
+    //--------------------------------------
+    // Runs work(client, channel, samples) on opt.clients threads, each
+    // with its own server connection, and reports the merged latencies
+    // as one phase. The I/O columns cover this (client) process only.
+    template <typename Work>
+    void clientPhase(const Options& opt, ostream& file, const string& name,
+                     const string& socketPath, Work work) {
+        Phase phase(name);
+        vector<vector<double> > samples(opt.clients);
+        vector<thread> threads;
+        for (int c = 0; c < opt.clients; ++c) {
+            threads.push_back(thread([&, c] {
+                SocketChannel channel;
+                if (!channel.connectTo(socketPath)) return;
+                work(c, channel, samples[c]);
+                string ignored;
+                channel.request({ "QUIT" }, ignored);
+            }));
+        }
+        for (thread& t : threads) t.join();
+        for (const vector<double>& s : samples) phase.add(s);
+        phase.report(opt, file, ",\"clients\":" + to_string(opt.clients));
+    }
+
+    //--------------------------------------
+    // One timed request; true if the server answered OK
+    bool timedRequest(SocketChannel& channel, const vector<string>& request,
+                      vector<double>& samples) {
+        string status;
+        Clock::time_point t0 = Clock::now();
+        bool sent = channel.request(request, status);
+        samples.push_back(chrono::duration<double, micro>(Clock::now() - t0).count());
+        return sent && status.compare(0, 2, "OK") == 0;
+    }
+
+}
+
+//--------------------------------------
+// Function: main
+// Purpose : Generates the data set and runs each timed phase.
+// in  : argc/argv - see Usage above
+// out : int - exit code (0 = success)
+//--------------------------------------
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        cerr << "Usage: superferry_bench [--records N] [--ops N] [--deletes N]"
+                " [--reports N] [--scans N] [--clients N] [--seed N] [--out FILE]" << endl;
+        return 1;
+    }
+
+    ofstream results(opt.out.c_str(), ios::app);
+    mt19937 rng(opt.seed);
+
+    // keep stdout to result lines: the lifecycle banners go to a sink
+    NullBuffer sink;
+    streambuf* console = cout.rdbuf(&sink);
+    if (!start()) {
+        cout.rdbuf(console);
+        return 1;
+    }
+    reset();    // always start from empty files
+    cout.rdbuf(console);
+
+    SailingManager sm;
+    sm.initialize();
+
+    Phase setup("generate");
+    long long sailingCount = generate(opt, sm);
+    ostringstream sizes;
+    sizes << ",\"sailings\":" << sailingCount
+          << ",\"vehicles\":" << max(1LL, opt.records / BOOKINGS_PER_VEHICLE)
+          << ",\"ferries\":" << FERRY_COUNT;
+    setup.report(opt, results, sizes.str());
+
+    ReservationService service(sm);
+    service.initialize();
+
+    uniform_int_distribution<long long> pickSailing(0, sailingCount - 1);
+    vector<pair<string, string> > booked;   // (plate, sailing) made by the booking phase
+
+    //============================
+    // Booking (new vehicle each, random sailing)
+    //============================
+    {
+        Phase phase("booking");
+        for (int i = 0; i < opt.ops; ++i) {
+            BookingRequest request;
+            request.licensePlate = plate('B', i);
+            request.phone = "604-555-" + to_string(1000 + i % 9000);
+            request.height = (i % 4 == 0) ? 3.0f : 2.0f;
+            request.length = (i % 4 == 0) ? 12.0f : 7.0f;
+            request.sailingId = sailingId(pickSailing(rng));
+
+            BookingResult result;
+            ServiceStatus status = ServiceStatus::OK;
+            phase.time([&] { status = service.createReservation(request, result); });
+            if (status == ServiceStatus::OK) booked.push_back(make_pair(request.licensePlate, request.sailingId));
+        }
+        phase.report(opt, results);
+    }
+
+    //============================
+    // Check-in
+    //============================
+    {
+        Phase phase("checkin");
+        for (const auto& entry : booked) {
+            phase.time([&] { service.checkIn(entry.first, entry.second); });
+        }
+        phase.report(opt, results);
+    }
+
+    //============================
+    // Cancellation (onboard reservations, so the count is restored too)
+    //============================
+    {
+        Phase phase("cancel");
+        for (const auto& entry : booked) {
+            CancelResult result;
+            phase.time([&] { service.cancelReservation(entry.first, entry.second, result); });
+        }
+        phase.report(opt, results);
+    }
+
+    //============================
+    // Sailing search: first page of matches for a tall vehicle
+    //============================
+    {
+        Phase phase("match_first_page");
+        for (int i = 0; i < opt.ops; ++i) {
+            int shown = 0;
+            phase.time([&] {
+                sm.getMatchingSailings(3.0f, 12.0f + i % 50, [&](const SailingRecord&) {
+                    return ++shown < 5;
+                });
+            });
+        }
+        phase.report(opt, results);
+    }
+
+    //============================
+    // Sailing deletion with reservation cascade
+    //============================
+    {
+        Phase phase("delete_sailing");
+        int deletes = static_cast<int>(min<long long>(opt.deletes, sailingCount));
+        for (int i = 0; i < deletes; ++i) {
+            string id = sailingId(sailingCount - 1 - i);
+            phase.time([&] { service.deleteSailing(id); });
+        }
+        phase.report(opt, results);
+    }
+
+    //============================
+    // Full report rendering (every sailing row, output discarded)
+    //============================
+    {
+        ostream null(&sink);
+        Phase phase("report");
+        int rows = sm.getSailingCount();
+        for (int i = 0; i < opt.reports; ++i) {
+            phase.time([&] { sm.renderReportRows(null, 0, rows); });
+        }
+        phase.report(opt, results, ",\"rows\":" + to_string(rows));
+    }
+
+    //============================
+    // Random reservation reads, with the page cache at its budget and
+    // turned off (every read then locks and copies from the mapping)
+    //============================
+    {
+        ReservationASM& reservations = StoreRegistry::reservations();
+        int rowCount = reservations.getRecordCount();
+        size_t budget = PageCache::budget();
+        double uncachedMean = 0;
+        for (size_t cacheBytes : { static_cast<size_t>(0), budget }) {
+            if (rowCount == 0) break;
+            PageCache::setBudget(cacheBytes);
+            mt19937 readRng(opt.seed);
+            uniform_int_distribution<int> pickRow(0, rowCount - 1);
+            Phase phase("record_get");
+            for (int i = 0; i < opt.ops * 10; ++i) {
+                int index = pickRow(readRng);
+                phase.time([&] { reservations.get(index); });
+            }
+            double mean = phase.mean();
+            if (cacheBytes == 0) uncachedMean = mean;
+
+            ostringstream extra;
+            extra.setf(ios::fixed);
+            extra.precision(2);
+            extra << ",\"cache_kb\":" << cacheBytes / 1024
+                  << ",\"speedup\":" << (mean > 0 ? uncachedMean / mean : 0.0);
+            phase.report(opt, results, extra.str());
+        }
+        PageCache::setBudget(budget);
+    }
+
+    //============================
+    // Key scans over reservations.dat, once per scan kernel: a sailing
+    // (4-byte key), a booking (sailing + plate, 14 bytes), and the
+    // onboard recount through ReservationASM. In memory mode the raw
+    // scans are skipped: a second handle would wait on the lock the
+    // process's own table holds.
+    //============================
+    {
+        RecordFile<ReservationRow> rows;
+        if (!WriteBehind::enabled()) rows.open("reservations.dat", "RESV");
+        int rowCount = rows.isOpen() ? rows.size() : 0;
+        vector<ReservationRow> probes;
+        if (rowCount > 0) {
+            uniform_int_distribution<int> pickRow(0, rowCount - 1);
+            for (int i = 0; i < opt.scans; ++i) {
+                ReservationRow row;
+                if (rows.get(pickRow(rng), row)) probes.push_back(row);
+            }
+        }
+        ReservationASM& reservations = StoreRegistry::reservations();
+
+        struct ScanBench {
+            string name;
+            function<size_t()> run;     // one timed scan, returns its hits
+        };
+        size_t probe = 0;
+        auto keyScan = [&](size_t width) {
+            return [&, width]() {
+                const ReservationRow& key = probes[probe++ % probes.size()];
+                return countEqual(rows.keys(offsetof(ReservationRow, sailingKey), width), &key);
+            };
+        };
+        vector<ScanBench> benches;
+        if (!probes.empty()) {
+            benches.push_back({ "key_scan_sailing", keyScan(sizeof(int)) });
+            benches.push_back({ "key_scan_booking", keyScan(offsetof(ReservationRow, laneUsed)) });
+        }
+        benches.push_back({ "onboard_tally", [&]() {
+            unordered_map<int, int> perSailing;
+            reservations.tallyOnboard(perSailing);
+            return perSailing.size();
+        } });
+
+        for (const ScanBench& bench : benches) {
+            double scalarMean = 0;
+            for (ScanKernel wanted : { ScanKernel::SCALAR, ScanKernel::SSE2, ScanKernel::AVX2 }) {
+                if (setScanKernel(wanted) != wanted) continue;     // not on this CPU
+                Phase phase(bench.name);
+                size_t hits = 0;
+                probe = 0;
+                for (int i = 0; i < opt.scans; ++i) {
+                    phase.time([&] { hits += bench.run(); });
+                }
+                double mean = phase.mean();
+                if (wanted == ScanKernel::SCALAR) scalarMean = mean;
+
+                ostringstream extra;
+                extra.setf(ios::fixed);
+                extra.precision(2);
+                extra << ",\"kernel\":\"" << scanKernelName(wanted) << "\""
+                      << ",\"speedup\":" << (mean > 0 ? scalarMean / mean : 0.0)
+                      << ",\"hits\":" << hits;
+                phase.report(opt, results, extra.str());
+            }
+        }
+        setScanKernel(ScanKernel::AUTO);
+        rows.close();
+    }
+
+    service.shutdown();
+    sm.close();
+    cout.rdbuf(&sink);
+    shutdown();
+    cout.rdbuf(console);
+
+    //============================
+    // Reservation server driven by N concurrent clients
+    //============================
+    if (opt.clients > 0) {
+        // files are closed above, so the server child inherits no
+        // mappings or locks and opens everything itself
+        const string socketPath = "bench.sock";
+        pid_t server = fork();
+        if (server == 0) {
+            cout.rdbuf(&sink);
+            ServerOptions options;
+            options.socketPath = socketPath;
+            _exit(serve(options));
+        }
+        if (server < 0) {
+            cerr << "[ERROR] Could not start the server" << endl;
+            return 1;
+        }
+
+        SocketChannel probe;
+        for (int tries = 0; tries < 500 && !probe.connectTo(socketPath); ++tries) {
+            usleep(10000);
+        }
+        if (!probe.isOpen()) {
+            cerr << "[ERROR] Server did not start listening" << endl;
+            kill(server, SIGTERM);
+            waitpid(server, nullptr, 0);
+            return 1;
+        }
+        probe.close();
+
+        // booking (new vehicle each, random sailing), then check-in of the same
+        vector<vector<pair<string, string> > > served(opt.clients);
+        clientPhase(opt, results, "server_booking", socketPath,
+                    [&](int c, SocketChannel& channel, vector<double>& samples) {
+            mt19937 clientRng(opt.seed + 1 + c);
+            for (int i = c; i < opt.ops; i += opt.clients) {
+                string vehicle = plate('S', i);
+                string sailing = sailingId(pickSailing(clientRng));
+                bool tall = (i % 4 == 0);
+                if (timedRequest(channel, { "BOOK", vehicle, "604-555-" + to_string(1000 + i % 9000),
+                                            tall ? "3.0" : "2.0", tall ? "12.0" : "7.0", sailing },
+                                 samples)) {
+                    served[c].push_back(make_pair(vehicle, sailing));
+                }
+            }
+        });
+        clientPhase(opt, results, "server_checkin", socketPath,
+                    [&](int c, SocketChannel& channel, vector<double>& samples) {
+            for (const auto& entry : served[c]) {
+                timedRequest(channel, { "CHECKIN", entry.first, entry.second }, samples);
+            }
+        });
+
+        kill(server, SIGTERM);
+        waitpid(server, nullptr, 0);
+    }
+    return 0;
+}
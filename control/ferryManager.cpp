@@ -18,9 +18,13 @@
 #include <iostream>
 #include <fstream>
 #include <cctype> 
+#include <cstring>
+#include <limits>
 
 #include "ferryManager.h"
+#include "reservationService.h"
 #include "../entity/ferryASM.h"
+#include "../system/ioTrace.h"
 #define MAX_FERRY_NAME_LENGTH 25
 #define MAX_HIGH_CAPACITY 3600
 #define MAX_LOW_CAPACITY 3600
@@ -33,7 +37,8 @@ void toUpperCase(char* str) {
     }
 }
 
-void createFerry() {
+void createFerry(ReservationService& service) {
+    IoFlow ioFlow("createFerry");
     char ferryName[MAX_FERRY_NAME_LENGTH + 1];
     int HCLL = -1, LCLL = -1, option = 0;
 
@@ -115,13 +120,16 @@ void createFerry() {
     }
 
     if (option == 1) {
-        if (FerryASM::writeFerry(ferryName, HCLL, LCLL)) {
+        ServiceStatus status = service.createFerry(ferryName, HCLL, LCLL);
+        if (status == ServiceStatus::OK) {
             cout << "\n--------------------------------------------------" << endl;
             cout << "Ferry Name:\t\t\t" << ferryName << endl;
             cout << "High Ceiling Lane Length:\t" << HCLL << " m" << endl;
             cout << "Low Ceiling Lane Length:\t" << LCLL << " m" << endl;
             cout << "--------------------------------------------------\n" << endl;
             cout << "Ferry record created successfully.\n" << endl;
+        } else if (status == ServiceStatus::ALREADY_EXISTS) {
+            cout << "[Error] A ferry named \"" << ferryName << "\" already exists.\n";
         } else {
             cout << "[Error] Failed to write ferry record to disk.\n";
         }
@@ -131,7 +139,8 @@ void createFerry() {
 }
 
 
-bool deleteFerry() {
+bool deleteFerry(ReservationService& service) {
+    IoFlow ioFlow("deleteFerry");
     Ferry ferryToDelete;
     bool quitMenu = false;
     bool proceed = true;
@@ -140,14 +149,33 @@ bool deleteFerry() {
     if (quitMenu) return false;
 
     if (proceed) {
-        if (FerryASM::deleteFerry(ferryToDelete.ferryName)) {
+        std::vector<std::string> assigned;
+        ServiceStatus status = service.deleteFerry(ferryToDelete.ferryName, &assigned);
+
+        // a ferry assigned to any sailing must stay
+        if (status == ServiceStatus::IN_USE) {
+            cout << "\n[WARNING] The ferry is in the following sailing(s):\n" << endl;
+
+            for (const std::string& sailingId : assigned) {
+                cout << sailingId << endl;
+            }
+
+            cin.ignore(128, '\n');
+            cout << "\nThe ferry cannot be deleted while it is assigned to a sailing. Press enter to continue." << endl;
+            cin.get();
+
+            return false;
+        }
+
+        if (status == ServiceStatus::OK) {
             cout << "\nFerry [" << ferryToDelete.ferryName << "] are deleted.\n" << endl;
             return true;
         }
+        cout << "[Error] " << statusText(status) << ".\n";
     } else {
         cout << "Press enter to continue." << endl;
         cin.get();
     }
     
     return false;
-}
\ No newline at end of file
+}
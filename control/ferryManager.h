@@ -17,22 +17,27 @@
 
 // using namespace std;
 
+class ReservationService;
+
 //--------------------------------------
-void createFerry();
+void createFerry(
+    ReservationService& service  // in: service that validates and stores the ferry
+);
 /*
 
 Prompts the user to input a ferry name and its lane capacity for both
-high-ceiling and low-ceiling vehicles. Validates the input and stores
-the ferry record using the FerryASM module.
-
-No parameters.
+high-ceiling and low-ceiling vehicles, then stores the ferry record
+through ReservationService::createFerry.
 */
 
 //--------------------------------------
-bool deleteFerry();
+bool deleteFerry(
+    ReservationService& service  // in: service that checks sailings and deletes the ferry
+);
 /*
 Lists ferries for the user to reference one for deletion.
-Removes ferry from system as long as no active sailings reference it.
+Removes ferry from system as long as no active sailings reference it;
+otherwise lists those sailings and leaves the ferry in place.
 */
 
 #endif // FERRYMANAGER_H
@@ -0,0 +1,181 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: importManager.cpp
+//
+// Command-line front end of the bulk import: parses the options,
+// splits the files into rows and prints the service's report.
+//***************************************************
+
+#include "importManager.h"
+#include "reservationService.h"
+#include "sailingManager.h"
+#include "../system/utilities.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cctype>
+
+using namespace std;
+
+namespace {
+    //--------------------------------------
+    // Trims spaces, tabs and a trailing CR
+    string trim(const string& text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == string::npos) return string();
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    //--------------------------------------
+    // Splits one line on tabs (if it has any) or commas.
+    // Double quotes group a CSV field; "" inside quotes is a quote.
+    vector<string> splitFields(const string& line) {
+        vector<string> fields;
+        char delimiter = (line.find('\t') != string::npos) ? '\t' : ',';
+
+        string field;
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (delimiter == ',' && c == '"') {
+                if (quoted && i + 1 < line.size() && line[i + 1] == '"') {
+                    field.push_back('"');
+                    ++i;
+                } else {
+                    quoted = !quoted;
+                }
+            } else if (c == delimiter && !quoted) {
+                fields.push_back(trim(field));
+                field.clear();
+            } else {
+                field.push_back(c);
+            }
+        }
+        fields.push_back(trim(field));
+        return fields;
+    }
+
+    //--------------------------------------
+    bool isHeader(const string& firstField) {
+        string name;
+        for (char c : firstField) name.push_back(tolower(static_cast<unsigned char>(c)));
+        return name == "name" || name == "ferry" || name == "ferry_name" ||
+               name == "sailing_id" || name == "sailing" ||
+               name == "plate" || name == "license_plate";
+    }
+
+    //--------------------------------------
+    // Reads every data line of path into rows. Returns false if the
+    // file cannot be opened.
+    bool readRows(const string& path, vector<ImportRow>& rows) {
+        ifstream in(path.c_str());
+        if (!in) return false;
+
+        string line;
+        int lineNumber = 0;
+        bool firstDataLine = true;
+        while (getline(in, line)) {
+            ++lineNumber;
+            string content = trim(line);
+            if (content.empty() || content[0] == '#') continue;
+
+            ImportRow row;
+            row.source = path + ":" + to_string(lineNumber);
+            row.fields = splitFields(content);
+
+            if (firstDataLine) {
+                firstDataLine = false;
+                if (isHeader(row.fields[0])) continue;
+            }
+            rows.push_back(row);
+        }
+        return true;
+    }
+
+    //--------------------------------------
+    void printCounts(const char* label, const ImportCounts& counts) {
+        cout << "  " << label << ":\t" << counts.added << " added, "
+             << counts.duplicates << " duplicate, "
+             << counts.rejected << " rejected" << endl;
+    }
+
+    //--------------------------------------
+    void printUsage() {
+        cout << "Usage: superferry import [--ferries FILE] [--sailings FILE]\n"
+             << "                         [--vehicles FILE] [--reservations FILE]\n"
+             << "                         [--stats-file FILE]\n"
+             << "Columns (comma- or tab-separated):\n"
+             << "  ferries      name, HCLL, LCLL\n"
+             << "  sailings     sailing ID, ferry name\n"
+             << "  vehicles     plate, phone, height, length\n"
+             << "  reservations plate, sailing ID [, onboard 0/1]" << endl;
+    }
+}
+
+//--------------------------------------
+int runImport(int argc, char* argv[]) {
+    ImportBatch batch;
+    bool anyFile = false;
+
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            setStatsFile(argv[++i]);
+            continue;
+        }
+        vector<ImportRow>* target = nullptr;
+        if      (strcmp(argv[i], "--ferries") == 0)      target = &batch.ferries;
+        else if (strcmp(argv[i], "--sailings") == 0)     target = &batch.sailings;
+        else if (strcmp(argv[i], "--vehicles") == 0)     target = &batch.vehicles;
+        else if (strcmp(argv[i], "--reservations") == 0) target = &batch.reservations;
+
+        if (target == nullptr || i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        if (!readRows(argv[++i], *target)) {
+            cout << "[ERROR] Could not open " << argv[i] << endl;
+            return 1;
+        }
+        anyFile = true;
+    }
+
+    if (!anyFile) {
+        printUsage();
+        return 1;
+    }
+
+    if (!start()) return 1;
+
+    SailingManager sm;
+    sm.initialize();
+    ReservationService service(sm);
+    service.initialize();
+
+    ImportReport report;
+    ServiceStatus status = service.importRecords(batch, report);
+
+    cout << "Import summary:" << endl;
+    printCounts("Ferries", report.ferries);
+    printCounts("Sailings", report.sailings);
+    printCounts("Vehicles", report.vehicles);
+    printCounts("Reservations", report.reservations);
+
+    for (const string& problem : report.problems) {
+        cout << "[REJECTED] " << problem << endl;
+    }
+    if (status != ServiceStatus::OK) {
+        cout << "[ERROR] Import failed: " << statusText(status)
+             << ". Sailings, vehicles and reservations were not written." << endl;
+    }
+
+    service.shutdown();
+    sm.close();
+    shutdown();
+
+    if (status != ServiceStatus::OK) return 1;
+    return report.problems.empty() ? 0 : 2;
+}
@@ -0,0 +1,38 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: importManager.h
+//
+// Non-interactive bulk load: `superferry import` reads CSV or TSV
+// files of ferries, sailings, vehicles and reservations and hands the
+// rows to ReservationService::importRecords, which validates,
+// deduplicates and writes each record file in one pass.
+//***************************************************
+
+#ifndef IMPORT_MANAGER_H
+#define IMPORT_MANAGER_H
+
+//--------------------------------------
+int runImport(
+    int argc,       // in: argument count from main
+    char* argv[]    // in: argv[1] is "import", options follow
+);
+/*
+Usage:
+  superferry import [--ferries FILE] [--sailings FILE]
+                    [--vehicles FILE] [--reservations FILE]
+
+One record per line, comma- or tab-separated (a line containing a tab
+is split on tabs). Blank lines and lines starting with '#' are skipped,
+as is a first line whose first column is the column name (name, ferry,
+sailing_id, plate). Columns:
+  ferries      - name, HCLL, LCLL
+  sailings     - sailing ID, ferry name
+  vehicles     - plate, phone, height, length
+  reservations - plate, sailing ID [, onboard 0/1]
+
+Prints a per-file summary and every rejected row. Returns the process
+exit code: 0 on success, 1 on a usage, file or storage error, 2 if the
+import finished but some rows were rejected.
+*/
+
+#endif // IMPORT_MANAGER_H
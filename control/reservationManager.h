@@ -15,23 +15,26 @@
 //       (createFlow writes laneUsed; deleteFlow restores capacity by lane)
 //
 // Handles user interaction logic for reservation-related commands.
-// Delegates validation and storage to ADT and entity layers.
+// Prompts and prints only; every change goes through ReservationService.
 //***************************************************
 
 #ifndef RESERVATION_MANAGER_H
 #define RESERVATION_MANAGER_H
 
-#include "../entity/vehicleASM.h"
-#include "../entity/reservationASM.h"
+#include "reservationService.h"
 
 class SailingManager;  // forward declaration
 
 class ReservationManager {
 private:
-    VehicleASM vehicleASM;
-    ReservationASM reservationASM;
+    ReservationService& service;
 
 public:
+    //--------------------------------------
+    explicit ReservationManager(
+        ReservationService& svc  // in: service that owns the vehicle/reservation files
+    );
+
     //===============================
     // File Lifecycle Functions
     //===============================
@@ -39,14 +42,15 @@ public:
     //--------------------------------------
     void initializeAll();
     /*
-    Initializes all related ASM modules (VehicleASM, ReservationASM).
-    Must be called before using any reservation functionality.
+    Makes sure the service's data files (VehicleASM, ReservationASM in
+    the StoreRegistry) are open. Must be called before using any
+    reservation functionality.
     */
 
     //--------------------------------------
     void shutdown();
     /*
-    Flushes and closes all open ASM modules.
+    Flushes the service's files; shutdown() in utilities closes them.
     Call during system shutdown.
     */
 
@@ -56,7 +60,7 @@ public:
 
     //--------------------------------------
     void createFlow(
-        SailingManager& sm       // in: sailing manager for matching and space checks
+        SailingManager& sm       // in: sailing manager for the sailing picker
     );
     /*
     Guides user through full reservation creation process:
@@ -67,9 +71,7 @@ public:
     */
 
     //--------------------------------------
-    void deleteFlow(
-        SailingManager& sm       // in: sailing manager for lane space restore
-    );
+    void deleteFlow();
     /*
     Deletes a confirmed reservation and restores sailing lane capacity
     using the persisted laneUsed from the reservation record.
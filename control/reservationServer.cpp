@@ -0,0 +1,375 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: reservationServer.cpp
+//
+// Socket setup, the connection loop, request parsing and dispatch to
+// ReservationService for `superferry serve`.
+//***************************************************
+
+#include "reservationServer.h"
+#include "reservationService.h"
+#include "sailingManager.h"
+#include "../entity/storeRegistry.h"
+#include "../system/socketChannel.h"
+#include "../system/utilities.h"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace std;
+
+namespace {
+    const int POLL_MS = 250;        // how often an idle server looks at the stop flag
+    const int MATCH_LIMIT = 10;     // MATCH rows when no limit is given
+    const size_t MAX_CLIENTS = 256; // connections open at once; more wait in the backlog
+
+    volatile sig_atomic_t stopRequested = 0;
+
+    void onStopSignal(int) {
+        stopRequested = 1;
+    }
+
+    //--------------------------------------
+    // The service and sailing manager every request runs against
+    struct Store {
+        SailingManager sailings;
+        ReservationService service;
+
+        Store() : service(sailings) {}
+    };
+
+    //--------------------------------------
+    // Reply under construction: status line plus data rows
+    struct Reply {
+        vector<string> status;
+        vector<string> rows;
+
+        void ok(const vector<string>& fields = vector<string>()) {
+            status.assign(1, "OK");
+            status.insert(status.end(), fields.begin(), fields.end());
+        }
+
+        void fail(const string& reason) {
+            status.assign(1, "ERR");
+            status.push_back(reason);
+            rows.clear();
+        }
+
+        void fail(ServiceStatus s, const string& detail = string()) {
+            fail(detail.empty() ? string(statusText(s)) : string(statusText(s)) + ": " + detail);
+        }
+
+        string text() const {
+            string out = wireLine(status) + "\n";
+            for (const string& row : rows) out += row + "\n";
+            return out + ".\n";
+        }
+    };
+
+    //--------------------------------------
+    string money(float value) {
+        ostringstream out;
+        out << fixed << setprecision(2) << value;
+        return out.str();
+    }
+
+    string metres(float value) {
+        ostringstream out;
+        out << fixed << setprecision(1) << value;
+        return out.str();
+    }
+
+    bool parseFloat(const string& text, float& value) {
+        char* end = nullptr;
+        value = strtof(text.c_str(), &end);
+        return !text.empty() && end != nullptr && *end == '\0';
+    }
+
+    bool parseCount(const string& text, int& value) {
+        char* end = nullptr;
+        long parsed = strtol(text.c_str(), &end, 10);
+        if (text.empty() || end == nullptr || *end != '\0' || parsed < 0 || parsed > 1000000)
+            return false;
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    //--------------------------------------
+    // Runs one request. Returns false if the connection should close.
+    bool handle(Store& store, const vector<string>& request, Reply& reply) {
+        const string& verb = request[0];
+        size_t args = request.size() - 1;
+
+        if (verb == "PING" && args == 0) {
+            reply.ok();
+        } else if (verb == "QUIT") {
+            reply.ok();
+            return false;
+        } else if (verb == "BOOK" && args == 5) {
+            BookingRequest booking;
+            booking.licensePlate = request[1];
+            booking.phone = request[2];
+            booking.sailingId = request[5];
+            if (!parseFloat(request[3], booking.height) || !parseFloat(request[4], booking.length)) {
+                reply.fail(ServiceStatus::INVALID_INPUT);
+                return true;
+            }
+
+            BookingResult result;
+            ServiceStatus s = store.service.createReservation(booking, result);
+            if (s == ServiceStatus::OK) {
+                reply.ok({ string(1, result.laneUsed), money(result.fare),
+                           result.vehicleCreated ? "1" : "0" });
+            } else {
+                reply.fail(s, result.detail);
+            }
+        } else if (verb == "CHECKIN" && args == 2) {
+            VehicleInfo vehicle;
+            ServiceStatus s = store.service.checkIn(request[1], request[2], &vehicle);
+            if (s == ServiceStatus::OK) reply.ok({ money(vehicle.fare) });
+            else reply.fail(s);
+        } else if (verb == "CANCEL" && args == 2) {
+            CancelResult result;
+            ServiceStatus s = store.service.cancelReservation(request[1], request[2], result);
+            if (s == ServiceStatus::OK) {
+                reply.ok({ result.laneFreed ? string(1, result.laneFreed) : string("-"),
+                           result.wasOnboard ? "1" : "0" });
+            } else {
+                reply.fail(s);
+            }
+        } else if (verb == "FIND" && args == 1) {
+            vector<ReservationInfo> found;
+            ServiceStatus s = store.service.findReservations(request[1], found);
+            if (s != ServiceStatus::OK && s != ServiceStatus::NOT_FOUND) {
+                reply.fail(s);
+                return true;
+            }
+            reply.ok({ to_string(found.size()) });
+            for (const ReservationInfo& r : found) {
+                reply.rows.push_back(wireLine({ r.sailingId, r.isOnboard ? "1" : "0",
+                                                string(1, r.laneUsed ? r.laneUsed : '-') }));
+            }
+        } else if (verb == "MATCH" && (args == 2 || args == 3)) {
+            float height, length;
+            int limit = MATCH_LIMIT;
+            if (!parseFloat(request[1], height) || !parseFloat(request[2], length) ||
+                (args == 3 && !parseCount(request[3], limit)) ||
+                !ReservationService::normalizeDimensions(height, length)) {
+                reply.fail(ServiceStatus::INVALID_INPUT);
+                return true;
+            }
+
+            vector<string> rows;
+            if (limit > 0) {
+                store.sailings.getMatchingSailings(height, length, [&](const SailingRecord& r) {
+                    rows.push_back(wireLine({ r.date, r.ferryName, metres(toMetres(r.highLaneRestDm)),
+                                              metres(toMetres(r.lowLaneRestDm)) }));
+                    return static_cast<int>(rows.size()) < limit;
+                });
+            }
+            reply.ok({ to_string(rows.size()) });
+            reply.rows.swap(rows);
+        } else if (verb == "REPORT" && args <= 2) {
+            int first = 0, count = -1;
+            if ((args >= 1 && !parseCount(request[1], first)) ||
+                (args == 2 && !parseCount(request[2], count))) {
+                reply.fail(ServiceStatus::INVALID_INPUT);
+                return true;
+            }
+
+            ostringstream rendered;
+            int total = store.sailings.getSailingCount();
+            int end = (count < 0 || first + count > total) ? total : first + count;
+            if (first < end) store.sailings.renderReportRows(rendered, first, end);
+            reply.ok({ to_string(total) });
+            istringstream lines(rendered.str());
+            string line;
+            while (getline(lines, line)) reply.rows.push_back(line);
+        } else {
+            reply.fail("Unknown request or wrong number of fields");
+        }
+        return true;
+    }
+
+    //--------------------------------------
+    // Runs every complete request a client has sent. Returns false once
+    // the connection should close (end of stream, QUIT, failed write).
+    bool serveReady(Store& store, SocketChannel& channel) {
+        string line;
+        while (true) {
+            ReadStatus got = channel.readLine(line, 0);
+            if (got == ReadStatus::TIMEOUT) return true;     // rest of the line still to come
+            if (got == ReadStatus::CLOSED) return false;
+            if (line.empty()) continue;
+
+            Reply reply;
+            bool keepOpen = handle(store, wireFields(line), reply);
+            if (!channel.writeAll(reply.text()) || !keepOpen) return false;
+        }
+    }
+
+    //--------------------------------------
+    // Takes every waiting connection off the (non-blocking) listening
+    // socket, up to MAX_CLIENTS open at once.
+    void acceptWaiting(int listenFd, vector<unique_ptr<SocketChannel> >& clients) {
+        while (clients.size() < MAX_CLIENTS) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) return;
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            clients.push_back(unique_ptr<SocketChannel>(new SocketChannel(fd)));
+        }
+    }
+
+    //--------------------------------------
+    // Binds and listens on path. A stale socket left by a server that
+    // died is replaced; a live one is an error.
+    int openListener(const string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            cerr << "[ERROR] Socket path too long: " << path << endl;
+            return -1;
+        }
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        struct stat st;
+        if (::lstat(path.c_str(), &st) == 0) {
+            SocketChannel probe;
+            if (!S_ISSOCK(st.st_mode)) {
+                cerr << "[ERROR] " << path << " exists and is not a socket" << endl;
+                return -1;
+            }
+            if (probe.connectTo(path)) {
+                cerr << "[ERROR] A server is already listening on " << path << endl;
+                return -1;
+            }
+            ::unlink(path.c_str());
+        }
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 ||
+            ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(fd, 64) != 0) {
+            cerr << "[ERROR] Could not listen on " << path << ": " << strerror(errno) << endl;
+            if (fd >= 0) ::close(fd);
+            return -1;
+        }
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return fd;
+    }
+
+    //--------------------------------------
+    void printUsage() {
+        cout << "Usage: superferry serve [--socket PATH] [--stats-file PATH]\n"
+             << "  --socket      socket to listen on (default " << DEFAULT_SOCKET_PATH << ")\n"
+             << "  --stats-file  write latency and cache statistics there on exit" << endl;
+    }
+}
+
+//--------------------------------------
+int serve(const ServerOptions& options) {
+    string path = options.socketPath.empty() ? string(DEFAULT_SOCKET_PATH) : options.socketPath;
+
+    int listenFd = openListener(path);
+    if (listenFd < 0) return 1;
+
+    stopRequested = 0;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onStopSignal;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    setStatsFile(options.statsFile);
+    if (!start()) {
+        ::close(listenFd);
+        ::unlink(path.c_str());
+        return 1;
+    }
+    Store store;
+    store.sailings.initialize();
+    store.service.initialize();
+
+    cout << "[Server] Listening on " << path << "." << endl;
+
+    // one thread: poll the listener and every client, then run the
+    // requests that arrived, one at a time
+    vector<unique_ptr<SocketChannel> > clients;
+    chrono::steady_clock::time_point revalidated = chrono::steady_clock::now();
+    while (!stopRequested) {
+        vector<pollfd> watched(1, pollfd{ listenFd, POLLIN, 0 });
+        for (const auto& client : clients) watched.push_back(pollfd{ client->handle(), POLLIN, 0 });
+
+        int ready = ::poll(watched.data(), watched.size(), POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            cerr << "[ERROR] poll failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        if (ready > 0) {
+            size_t keep = 0;
+            for (size_t i = 0; i < clients.size(); ++i) {
+                bool open = watched[i + 1].revents == 0 || serveReady(store, *clients[i]);
+                if (open) clients[keep++].swap(clients[i]);
+            }
+            clients.resize(keep);
+            if (watched[0].revents != 0) acceptWaiting(listenFd, clients);
+        }
+
+        // between requests, pick up data files restored over ours
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (now - revalidated >= chrono::milliseconds(POLL_MS)) {
+            StoreRegistry::revalidate();
+            revalidated = now;
+        }
+    }
+    clients.clear();
+
+    ::close(listenFd);
+    ::unlink(path.c_str());
+    cout << "[Server] Stopped." << endl;
+
+    store.service.shutdown();
+    store.sailings.close();
+    shutdown();
+    return 0;
+}
+
+//--------------------------------------
+int runServe(int argc, char* argv[]) {
+    ServerOptions options;
+    for (int i = 2; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        if (strcmp(argv[i], "--socket") == 0) {
+            options.socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--stats-file") == 0) {
+            options.statsFile = argv[++i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    return serve(options);
+}
@@ -0,0 +1,66 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: reservationServer.h
+//
+// `superferry serve`: listens on a Unix domain socket and runs booking,
+// check-in, cancellation, lookup and report requests from many clients
+// (booth terminals, the benchmark) against one ReservationService.
+//
+// The server is single-threaded: one poll() loop accepts connections
+// (up to 256 open at once; more wait in the listen backlog) and runs
+// each request as it arrives, one at a time. The write-ahead log
+// transaction, the in-memory indexes and the shared ASM handles are
+// per process, not per thread, so requests on different sailings are
+// not run in parallel; many clients are served by interleaving them.
+//
+// Other superferry processes (the menu, an import) may share the data
+// directory meanwhile; the record locks in recordFile.h keep them apart.
+//***************************************************
+
+#ifndef RESERVATION_SERVER_H
+#define RESERVATION_SERVER_H
+
+#include <string>
+
+//--------------------------------------
+// Options of serve()
+struct ServerOptions {
+    std::string socketPath;     // defaults to DEFAULT_SOCKET_PATH
+    std::string statsFile;      // diagnostics written at shutdown (empty = none)
+};
+
+//--------------------------------------
+int serve(
+    const ServerOptions& options  // in: socket path and statistics file
+);
+/*
+Opens the data files, listens and serves until SIGINT or SIGTERM, then
+closes the socket and the files. Returns 0, or 1 if the socket could
+not be set up (for example, another server is already listening).
+*/
+
+//--------------------------------------
+int runServe(
+    int argc,       // in: argument count from main
+    char* argv[]    // in: argv[1] is "serve", options follow
+);
+/*
+Usage:
+  superferry serve [--socket PATH] [--stats-file PATH]
+
+Requests (one line each, fields separated by tabs):
+  PING
+  BOOK     plate, phone, height, length, sailing ID
+           -> OK, lane, fare, 1 if the vehicle was new
+  CHECKIN  plate, sailing ID        -> OK, fare
+  CANCEL   plate, sailing ID        -> OK, lane freed ('-' if none), onboard 0/1
+  FIND     plate                    -> OK, count; rows: sailing ID, onboard, lane
+  MATCH    height, length [, limit] -> OK, count; rows: sailing ID, ferry,
+                                       high lane rest, low lane rest
+  REPORT   [first [, count]]        -> OK, total; rows: report lines
+  QUIT                              -> OK, then the server closes the connection
+Every reply ends with a "." line; failures are "ERR", reason.
+Returns the process exit code.
+*/
+
+#endif // RESERVATION_SERVER_H
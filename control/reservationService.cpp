@@ -0,0 +1,735 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: reservationService.cpp
+//
+// Headless implementation of the SuperFerry operations. Each call
+// validates, writes through the ASM layer and ends with exactly one
+// write-ahead-log commit (a Transaction where several files change).
+//***************************************************
+
+#include "reservationService.h"
+#include "sailingManager.h"
+#include "../entity/storeRegistry.h"
+#include "../system/ioTrace.h"
+#include "../system/latencyStats.h"
+#include "../system/writeAheadLog.h"
+
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace {
+    const int MAX_FERRY_NAME_LENGTH = 25;
+    const int MAX_LANE_CAPACITY     = 3600;
+
+    ReservationInfo toInfo(const ReservationRecord& rec) {
+        ReservationInfo info;
+        info.licensePlate = std::string(rec.licensePlate, strnlen(rec.licensePlate, sizeof(rec.licensePlate)));
+        info.sailingId    = std::string(rec.sailingId, strnlen(rec.sailingId, sizeof(rec.sailingId)));
+        info.isOnboard    = rec.isOnboard;
+        info.laneUsed     = rec.laneUsed;
+        return info;
+    }
+
+    std::string toUpper(std::string text) {
+        for (char& c : text) c = std::toupper(static_cast<unsigned char>(c));
+        return text;
+    }
+
+    bool isValidFerry(const std::string& name, int HCLL, int LCLL) {
+        return !name.empty() && name.length() <= MAX_FERRY_NAME_LENGTH &&
+               HCLL >= 0 && HCLL <= MAX_LANE_CAPACITY &&
+               LCLL >= 0 && LCLL <= MAX_LANE_CAPACITY &&
+               (HCLL != 0 || LCLL != 0);
+    }
+
+    // whole-field numeric parses for import rows
+    bool parseInt(const std::string& text, int& out) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (*end != '\0' || value < -1000000 || value > 1000000) return false;
+        out = static_cast<int>(value);
+        return true;
+    }
+
+    bool parseFloat(const std::string& text, float& out) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        out = std::strtof(text.c_str(), &end);
+        return *end == '\0';
+    }
+
+    bool parseFlag(const std::string& text, bool& out) {
+        std::string flag = toUpper(text);
+        if (flag.empty() || flag == "0" || flag == "N" || flag == "NO")  { out = false; return true; }
+        if (flag == "1" || flag == "Y" || flag == "YES")                 { out = true;  return true; }
+        return false;
+    }
+}
+
+//--------------------------------------
+const char* statusText(ServiceStatus status) {
+    switch (status) {
+        case ServiceStatus::OK:                 return "OK";
+        case ServiceStatus::INVALID_INPUT:      return "Invalid input";
+        case ServiceStatus::NOT_FOUND:          return "Not found";
+        case ServiceStatus::ALREADY_EXISTS:     return "Already exists";
+        case ServiceStatus::VEHICLE_MISMATCH:   return "Vehicle details do not match the registered vehicle";
+        case ServiceStatus::NO_CAPACITY:        return "Not enough lane space";
+        case ServiceStatus::ALREADY_CHECKED_IN: return "Already checked in";
+        case ServiceStatus::IN_USE:             return "Still assigned to a sailing";
+        case ServiceStatus::STORAGE_ERROR:      return "Storage error";
+    }
+    return "Unknown";
+}
+
+//--------------------------------------
+ReservationService::ReservationService(SailingManager& sm)
+    : sailings(sm),
+      vehicleASM(StoreRegistry::vehicles()),
+      reservationASM(StoreRegistry::reservations()) {}
+
+//--------------------------------------
+void ReservationService::initialize() {
+    StoreRegistry::openAll();
+}
+
+//--------------------------------------
+void ReservationService::shutdown() {
+    vehicleASM.flush();
+}
+
+//======================================
+// Validation helpers
+//======================================
+
+//--------------------------------------
+float ReservationService::calculateFare(const Vehicle& v) {
+    if (v.specialHeight <= 2.0f && v.specialLength <= 7.0f) {
+        return 14.0f;
+    } else if (v.specialHeight > 2.0f) {
+        return v.specialLength * 3.0f;
+    } else {
+        return v.specialLength * 2.0f;
+    }
+}
+
+//--------------------------------------
+std::string ReservationService::normalizePhoneNumber(const std::string& raw) {
+    std::string digits;
+    for (char c : raw) {
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            digits.push_back(c);
+        }
+    }
+
+    if (digits.length() == 7)
+        return digits.substr(0, 3) + "-" + digits.substr(3, 4);
+    else if (digits.length() == 10)
+        return digits.substr(0, 3) + "-" + digits.substr(3, 3) + "-" + digits.substr(6, 4);
+    else if (digits.length() == 11)
+        return digits.substr(0, 1) + "-" + digits.substr(1, 3) + "-" + digits.substr(4, 3) + "-" + digits.substr(7, 4);
+
+    return "";
+}
+
+//--------------------------------------
+bool ReservationService::normalizeLicensePlate(std::string& plate) {
+    if (plate.length() < 1 || plate.length() > 10) return false;
+
+    for (char& c : plate) {
+        if (!std::isdigit(static_cast<unsigned char>(c)) &&
+            !std::isalpha(static_cast<unsigned char>(c)) &&
+            c != '-') {
+            return false;
+        }
+        c = std::toupper(static_cast<unsigned char>(c));
+    }
+    return true;
+}
+
+//--------------------------------------
+bool ReservationService::normalizeDimensions(float& height, float& length) {
+    if (!(height > 0.0f && height <= 9.9f && length > 0.0f && length <= 99.9f)) return false;
+
+    height = std::ceil(height * 10.0f) / 10.0f;
+    length = std::ceil(length * 10.0f) / 10.0f;
+    if (height < 2.0f) height = 2.0f;
+    if (length < 7.0f) length = 7.0f;
+    return height <= 9.9f && length <= 99.9f;
+}
+
+//--------------------------------------
+// Index of the plate's reservation on a sailing, or -1
+int ReservationService::findReservationIndex(const std::string& plate, const std::string& sailingId) {
+    for (int idx : reservationASM.findAllIndexesByLicense(plate.c_str())) {
+        ReservationRecord rec = reservationASM.get(idx);
+        if (strncmp(rec.sailingId, sailingId.c_str(), sizeof(rec.sailingId)) == 0) return idx;
+    }
+    return -1;
+}
+
+//======================================
+// Reservations
+//======================================
+
+//--------------------------------------
+ServiceStatus ReservationService::createReservation(const BookingRequest& request, BookingResult& result) {
+    static LatencyProbe latencyProbe("service.createReservation");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.createReservation");
+    result = BookingResult();
+
+    std::string plate = request.licensePlate;
+    std::string phone = normalizePhoneNumber(request.phone);
+    float height = request.height;
+    float length = request.length;
+    char sailingId[DATE_LEN];
+
+    if (!normalizeLicensePlate(plate) || phone.empty() ||
+        !normalizeDimensions(height, length) ||
+        !sailings.isValidSailingId(request.sailingId.c_str(), sailingId)) {
+        return ServiceStatus::INVALID_INPUT;
+    }
+    if (!sailings.sailingExists(sailingId)) return ServiceStatus::NOT_FOUND;
+    if (reservationASM.existsReservation(plate.c_str(), sailingId)) return ServiceStatus::ALREADY_EXISTS;
+
+    Vehicle v{};
+    strncpy(v.licensePlate, plate.c_str(), sizeof(v.licensePlate) - 1);
+    strncpy(v.customerPhone, phone.c_str(), sizeof(v.customerPhone) - 1);
+    v.specialHeight = height;
+    v.specialLength = length;
+
+    // Vehicle, lane deduction and reservation are staged in one
+    // transaction: nothing reaches the data files unless all three
+    // succeed, and returning early discards the staged writes.
+    Transaction booking;
+
+    VehicleUpsert vehicle = vehicleASM.upsertIfConsistent(v, result.vehicleCreated, result.detail);
+    if (vehicle == VehicleUpsert::MISMATCH) return ServiceStatus::VEHICLE_MISMATCH;
+    if (vehicle != VehicleUpsert::OK) return ServiceStatus::STORAGE_ERROR;
+
+    // bookings on one sailing queue on its record lock, so the
+    // duplicate check above is only final once the lock is held
+    if (!sailings.lockSailing(sailingId)) return ServiceStatus::NOT_FOUND;
+    if (reservationASM.existsReservation(plate.c_str(), sailingId)) return ServiceStatus::ALREADY_EXISTS;
+
+    char lane = sailings.allocateLane(sailingId, height, length);
+    if (lane != 'H' && lane != 'L') return ServiceStatus::NO_CAPACITY;
+
+    if (!reservationASM.writeReservationRecord(plate.c_str(), sailingId, /*isOnboard=*/false, /*laneUsed=*/lane)) {
+        return ServiceStatus::STORAGE_ERROR;
+    }
+
+    // one log write (and sync) for the whole booking, then applied
+    if (!booking.commit()) return ServiceStatus::STORAGE_ERROR;
+
+    // onboardVehicleCount is only bumped at check-in
+    result.laneUsed = lane;
+    result.fare = calculateFare(v);
+    return ServiceStatus::OK;
+}
+
+//--------------------------------------
+bool ReservationService::hasReservation(const std::string& licensePlate, const std::string& sailingId) {
+    std::string plate = licensePlate;
+    char id[DATE_LEN];
+    if (!normalizeLicensePlate(plate) || !sailings.isValidSailingId(sailingId.c_str(), id)) return false;
+    return reservationASM.existsReservation(plate.c_str(), id);
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::findReservations(const std::string& licensePlate,
+                                                   std::vector<ReservationInfo>& out,
+                                                   int* purged) {
+    static LatencyProbe latencyProbe("service.findReservations");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.findReservations");
+    out.clear();
+    if (purged) *purged = 0;
+
+    std::string plate = licensePlate;
+    if (!normalizeLicensePlate(plate)) return ServiceStatus::INVALID_INPUT;
+
+    std::vector<int> indexes = reservationASM.findAllIndexesByLicense(plate.c_str());
+    if (indexes.empty()) return ServiceStatus::NOT_FOUND;
+
+    // drop reservations left behind by deleted sailings; the sailings
+    // are looked up first, as sailings come before reservations in the
+    // lock order. Each is found through the plate index and swap-deleted
+    // under its record and tail locks, like a cancellation.
+    std::unordered_set<std::string> orphans;
+    for (int idx : indexes) {
+        ReservationRecord rec = reservationASM.get(idx);
+        std::string id(rec.sailingId, strnlen(rec.sailingId, sizeof(rec.sailingId)));
+        if (!sailings.sailingExists(id.c_str())) orphans.insert(id);
+    }
+    if (!orphans.empty()) {
+        int removed = 0;
+        Transaction purge;
+        for (const std::string& id : orphans) {
+            int idx;
+            while ((idx = reservationASM.lockReservation(plate.c_str(), id.c_str())) >= 0 &&
+                   reservationASM.deleteReservationByIndex(idx)) {
+                ++removed;
+            }
+        }
+        if (!purge.commit()) return ServiceStatus::STORAGE_ERROR;
+        if (purged) *purged = removed;
+        indexes = reservationASM.findAllIndexesByLicense(plate.c_str());
+    }
+
+    for (int idx : indexes) {
+        out.push_back(toInfo(reservationASM.get(idx)));
+    }
+    return ServiceStatus::OK;
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::getVehicle(const std::string& licensePlate, VehicleInfo& out) {
+    out = VehicleInfo();
+    std::string plate = licensePlate;
+    if (!normalizeLicensePlate(plate)) return ServiceStatus::INVALID_INPUT;
+    if (vehicleASM.findByPlate(plate.c_str(), out.vehicle) < 0) return ServiceStatus::NOT_FOUND;
+
+    out.isSpecial = (out.vehicle.specialHeight > 2.0f || out.vehicle.specialLength > 7.0f);
+    out.fare = calculateFare(out.vehicle);
+    return ServiceStatus::OK;
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::checkIn(const std::string& licensePlate,
+                                          const std::string& sailingId,
+                                          VehicleInfo* vehicle) {
+    static LatencyProbe latencyProbe("service.checkIn");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.checkIn");
+    std::string plate = licensePlate;
+    char id[DATE_LEN];
+    if (!normalizeLicensePlate(plate) || !sailings.isValidSailingId(sailingId.c_str(), id)) {
+        return ServiceStatus::INVALID_INPUT;
+    }
+
+    // a reservation on a deleted sailing cannot be checked in
+    int idx = findReservationIndex(plate, id);
+    if (idx < 0 || !sailings.sailingExists(id)) return ServiceStatus::NOT_FOUND;
+    if (reservationASM.get(idx).isOnboard) return ServiceStatus::ALREADY_CHECKED_IN;
+
+    if (vehicle) getVehicle(plate, *vehicle);
+
+    // lock the sailing, then the reservation, and check again under
+    // the locks: another booth may have got there first
+    Transaction checkin;
+    if (!sailings.lockSailing(id)) return ServiceStatus::NOT_FOUND;
+    idx = reservationASM.lockReservation(plate.c_str(), id);
+    if (idx < 0) return ServiceStatus::NOT_FOUND;
+    if (reservationASM.get(idx).isOnboard) return ServiceStatus::ALREADY_CHECKED_IN;
+
+    if (!sailings.updateOnboardCount(id, +1)) return ServiceStatus::STORAGE_ERROR;
+    if (!reservationASM.checkInReservationByIndex(idx)) return ServiceStatus::STORAGE_ERROR;
+    if (!checkin.commit()) return ServiceStatus::STORAGE_ERROR;
+
+    return ServiceStatus::OK;
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::cancelReservation(const std::string& licensePlate,
+                                                    const std::string& sailingId,
+                                                    CancelResult& result) {
+    static LatencyProbe latencyProbe("service.cancelReservation");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.cancelReservation");
+    result = CancelResult();
+
+    std::string plate = licensePlate;
+    char id[DATE_LEN];
+    if (!normalizeLicensePlate(plate) || !sailings.isValidSailingId(sailingId.c_str(), id)) {
+        return ServiceStatus::INVALID_INPUT;
+    }
+
+    if (findReservationIndex(plate, id) < 0) return ServiceStatus::NOT_FOUND;
+
+    // the vehicle's length is what goes back to the lane
+    Vehicle v{};
+    bool vehicleFound = vehicleASM.findByPlate(plate.c_str(), v) >= 0;
+
+    // sailing (if it still exists), then the reservation, read again
+    // under the lock in case it was checked in or cancelled meanwhile
+    Transaction cancel;
+    bool sailingExists = sailings.lockSailing(id);
+    int idx = reservationASM.lockReservation(plate.c_str(), id);
+    if (idx < 0) return ServiceStatus::NOT_FOUND;
+    ReservationRecord selected = reservationASM.get(idx);
+    result.wasOnboard = selected.isOnboard;
+
+    // the lane length must go back with the reservation, or it is lost
+    // for good: without the vehicle (or the write) nothing is cancelled
+    if (sailingExists) {
+        if (!vehicleFound) {
+            cerr << "[ERROR] Vehicle " << plate << " of the reservation on " << id
+                 << " is not registered; the lane length cannot be given back." << endl;
+            return ServiceStatus::NOT_FOUND;
+        }
+        if (selected.isOnboard && !sailings.updateOnboardCount(id, -1)) return ServiceStatus::STORAGE_ERROR;
+        if (!sailings.releaseLane(id, v.specialLength, selected.laneUsed)) return ServiceStatus::STORAGE_ERROR;
+        result.laneFreed = selected.laneUsed;
+    }
+    if (!reservationASM.deleteReservationByIndex(idx)) return ServiceStatus::STORAGE_ERROR;
+    if (!cancel.commit()) return ServiceStatus::STORAGE_ERROR;
+
+    return ServiceStatus::OK;
+}
+
+//--------------------------------------
+std::vector<ReservationInfo> ReservationService::listReservations() {
+    static LatencyProbe latencyProbe("service.listReservations");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.listReservations");
+    std::vector<ReservationInfo> out;
+    int count = reservationASM.getRecordCount();
+    out.reserve(count);
+
+    for (int idx = 0; idx < count; ++idx) {
+        out.push_back(toInfo(reservationASM.get(idx)));
+    }
+    return out;
+}
+
+//--------------------------------------
+std::vector<Vehicle> ReservationService::listVehicles() {
+    static LatencyProbe latencyProbe("service.listVehicles");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.listVehicles");
+    std::vector<Vehicle> out;
+    int count = vehicleASM.getRecordCount();
+    out.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        Vehicle v{};
+        if (vehicleASM.getRecord(i, v)) out.push_back(v);
+    }
+    return out;
+}
+
+//======================================
+// Sailings and Ferries
+//======================================
+
+//--------------------------------------
+ServiceStatus ReservationService::createSailing(const std::string& sailingId, const std::string& ferryName) {
+    static LatencyProbe latencyProbe("service.createSailing");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.createSailing");
+    char id[DATE_LEN];
+    if (!sailings.isValidSailingId(sailingId.c_str(), id)) return ServiceStatus::INVALID_INPUT;
+
+    std::string name = toUpper(ferryName);
+
+    Ferry ferry;
+    if (!FerryASM::findFerry(name.c_str(), ferry)) return ServiceStatus::NOT_FOUND;
+    if (sailings.sailingExists(id)) return ServiceStatus::ALREADY_EXISTS;
+
+    SailingRecord record{};
+    strncpy(record.date, id, DATE_LEN);
+    strncpy(record.ferryName, ferry.ferryName, NAME_LEN);
+    record.ferryName[NAME_LEN - 1] = '\0';
+    record.highLaneRestDm = ferry.HCLL * 10;
+    record.lowLaneRestDm = ferry.LCLL * 10;
+
+    if (sailings.addSailing(record)) return ServiceStatus::OK;
+    return sailings.sailingExists(id) ? ServiceStatus::ALREADY_EXISTS : ServiceStatus::STORAGE_ERROR;
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::deleteSailing(const std::string& sailingId) {
+    static LatencyProbe latencyProbe("service.deleteSailing");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.deleteSailing");
+    char id[DATE_LEN];
+    if (!sailings.isValidSailingId(sailingId.c_str(), id)) return ServiceStatus::INVALID_INPUT;
+    if (!sailings.sailingExists(id)) return ServiceStatus::NOT_FOUND;
+
+    return sailings.deleteSailingByDate(id) ? ServiceStatus::OK : ServiceStatus::STORAGE_ERROR;
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::createFerry(const std::string& ferryName, int HCLL, int LCLL) {
+    static LatencyProbe latencyProbe("service.createFerry");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.createFerry");
+    std::string name = toUpper(ferryName);
+    if (!isValidFerry(name, HCLL, LCLL)) return ServiceStatus::INVALID_INPUT;
+    if (FerryASM::ferryExists(name.c_str())) return ServiceStatus::ALREADY_EXISTS;
+
+    bool written = FerryASM::writeFerry(name.c_str(), HCLL, LCLL);
+    WriteAheadLog::commit();
+    if (written) return ServiceStatus::OK;
+    return FerryASM::ferryExists(name.c_str()) ? ServiceStatus::ALREADY_EXISTS : ServiceStatus::STORAGE_ERROR;
+}
+
+//--------------------------------------
+ServiceStatus ReservationService::deleteFerry(const std::string& ferryName,
+                                              std::vector<std::string>* assignedSailings) {
+    static LatencyProbe latencyProbe("service.deleteFerry");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.deleteFerry");
+    if (assignedSailings) assignedSailings->clear();
+
+    std::string name = toUpper(ferryName);
+
+    // ferries, then sailings, held from the in-use check to the delete
+    // so no booth can add a sailing for the ferry in between
+    Transaction removal;
+    if (!FerryASM::lockAll() || !sailings.lockAllSailings()) return ServiceStatus::STORAGE_ERROR;
+    if (!FerryASM::ferryExists(name.c_str())) return ServiceStatus::NOT_FOUND;
+
+    // a ferry assigned to any sailing must stay
+    if (sailings.ferryInUse(name.c_str())) {
+        if (assignedSailings) {
+            for (int slot : sailings.getSailingsWithFerry(name.c_str())) {
+                SailingRecord sailing;
+                if (sailings.getSailingByIndex(slot, sailing)) {
+                    assignedSailings->push_back(sailing.date);
+                }
+            }
+        }
+        return ServiceStatus::IN_USE;
+    }
+
+    if (!FerryASM::deleteFerry(name.c_str())) return ServiceStatus::STORAGE_ERROR;
+    return removal.commit() ? ServiceStatus::OK : ServiceStatus::STORAGE_ERROR;
+}
+
+//======================================
+// Bulk Import
+//======================================
+
+//--------------------------------------
+ServiceStatus ReservationService::importRecords(const ImportBatch& batch, ImportReport& report) {
+    static LatencyProbe latencyProbe("service.importRecords");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("service.importRecords");
+    report = ImportReport();
+
+    auto reject = [&](ImportCounts& counts, const ImportRow& row, const std::string& reason) {
+        counts.rejected++;
+        report.problems.push_back(row.source + ": " + reason);
+    };
+
+    //============================
+    // Ferries (committed on their own so sailings can look them up;
+    // the ferry file stays locked from the duplicate checks to the write)
+    //============================
+    if (!batch.ferries.empty() && !FerryASM::lockAll()) return ServiceStatus::STORAGE_ERROR;
+    std::vector<Ferry> newFerries;
+    std::unordered_set<std::string> batchFerryNames;
+    for (const ImportRow& row : batch.ferries) {
+        int HCLL = 0, LCLL = 0;
+        if (row.fields.size() != 3) { reject(report.ferries, row, "expected name, HCLL, LCLL"); continue; }
+
+        std::string name = toUpper(row.fields[0]);
+        if (!parseInt(row.fields[1], HCLL) || !parseInt(row.fields[2], LCLL) || !isValidFerry(name, HCLL, LCLL)) {
+            reject(report.ferries, row, "invalid ferry (name 1-25 chars, lanes 0-3600, not both 0)");
+            continue;
+        }
+        if (FerryASM::ferryExists(name.c_str()) || !batchFerryNames.insert(name).second) {
+            report.ferries.duplicates++;
+            continue;
+        }
+
+        Ferry ferry{};
+        strncpy(ferry.ferryName, name.c_str(), sizeof(ferry.ferryName) - 1);
+        ferry.HCLL = HCLL;
+        ferry.LCLL = LCLL;
+        newFerries.push_back(ferry);
+    }
+    if (!FerryASM::writeFerries(newFerries)) {
+        WriteAheadLog::commit();
+        return ServiceStatus::STORAGE_ERROR;
+    }
+    if (!WriteAheadLog::commit()) return ServiceStatus::STORAGE_ERROR;
+    report.ferries.added = static_cast<int>(newFerries.size());
+
+    // The rest is checked against the files and written in one
+    // transaction, with vehicles, sailings and reservations locked
+    // whole (in that order) so no booth changes them in between.
+    Transaction import;
+    if (!vehicleASM.lockAll() || !sailings.lockAllSailings() || !reservationASM.lockAll()) {
+        return ServiceStatus::STORAGE_ERROR;
+    }
+
+    //============================
+    // Sailings
+    //============================
+    std::vector<SailingRecord> newSailings;
+    std::unordered_map<std::string, int> newSailingSlot;     // ID -> position in newSailings
+    for (const ImportRow& row : batch.sailings) {
+        char id[DATE_LEN];
+        if (row.fields.size() != 2) { reject(report.sailings, row, "expected sailing ID, ferry name"); continue; }
+        if (!sailings.isValidSailingId(row.fields[0].c_str(), id)) {
+            reject(report.sailings, row, "invalid sailing ID (TTT-DD-HH)");
+            continue;
+        }
+
+        Ferry ferry;
+        if (!FerryASM::findFerry(toUpper(row.fields[1]).c_str(), ferry)) {
+            reject(report.sailings, row, "unknown ferry " + row.fields[1]);
+            continue;
+        }
+        if (sailings.sailingExists(id) || newSailingSlot.count(id)) {
+            report.sailings.duplicates++;
+            continue;
+        }
+
+        SailingRecord record{};
+        strncpy(record.date, id, DATE_LEN);
+        strncpy(record.ferryName, ferry.ferryName, NAME_LEN);
+        record.ferryName[NAME_LEN - 1] = '\0';
+        record.highLaneRestDm = ferry.HCLL * 10;
+        record.lowLaneRestDm = ferry.LCLL * 10;
+        newSailingSlot[id] = static_cast<int>(newSailings.size());
+        newSailings.push_back(record);
+    }
+
+    //============================
+    // Vehicles
+    //============================
+    std::vector<Vehicle> newVehicles;
+    std::unordered_map<std::string, int> newVehicleSlot;     // plate -> position in newVehicles
+    for (const ImportRow& row : batch.vehicles) {
+        if (row.fields.size() != 4) { reject(report.vehicles, row, "expected plate, phone, height, length"); continue; }
+
+        std::string plate = row.fields[0];
+        std::string phone = normalizePhoneNumber(row.fields[1]);
+        float height = 0.0f, length = 0.0f;
+        if (!normalizeLicensePlate(plate) || phone.empty() ||
+            !parseFloat(row.fields[2], height) || !parseFloat(row.fields[3], length) ||
+            !normalizeDimensions(height, length)) {
+            reject(report.vehicles, row, "invalid vehicle (plate, phone or size)");
+            continue;
+        }
+
+        Vehicle v{};
+        strncpy(v.licensePlate, plate.c_str(), sizeof(v.licensePlate) - 1);
+        strncpy(v.customerPhone, phone.c_str(), sizeof(v.customerPhone) - 1);
+        v.specialHeight = height;
+        v.specialLength = length;
+
+        // a known plate is a duplicate if it matches, a conflict otherwise
+        Vehicle existing{};
+        auto slot = newVehicleSlot.find(plate);
+        bool known = false;
+        if (slot != newVehicleSlot.end()) {
+            existing = newVehicles[slot->second];
+            known = true;
+        } else {
+            known = vehicleASM.findByPlate(plate.c_str(), existing) >= 0;
+        }
+        if (known) {
+            std::string why;
+            if (VehicleASM::isConsistent(existing, v, why)) {
+                report.vehicles.duplicates++;
+            } else {
+                size_t start = why.find_first_not_of(" \n");
+                reject(report.vehicles, row, start == std::string::npos ? "vehicle mismatch" : why.substr(start));
+            }
+            continue;
+        }
+
+        newVehicleSlot[plate] = static_cast<int>(newVehicles.size());
+        newVehicles.push_back(v);
+    }
+
+    //============================
+    // Reservations (lane space taken from in-memory sailing copies)
+    //============================
+    std::vector<ReservationRecord> newReservations;
+    std::unordered_set<std::string> booked;                  // plate|ID within the batch
+    std::unordered_map<std::string, SailingRecord> changed;  // stored sailings with new bookings
+    for (const ImportRow& row : batch.reservations) {
+        char id[DATE_LEN];
+        bool onboard = false;
+        if (row.fields.size() != 2 && row.fields.size() != 3) {
+            reject(report.reservations, row, "expected plate, sailing ID [, onboard]");
+            continue;
+        }
+
+        std::string plate = row.fields[0];
+        if (!normalizeLicensePlate(plate) || !sailings.isValidSailingId(row.fields[1].c_str(), id) ||
+            (row.fields.size() == 3 && !parseFlag(row.fields[2], onboard))) {
+            reject(report.reservations, row, "invalid reservation (plate, sailing ID or onboard flag)");
+            continue;
+        }
+
+        std::string key = plate + "|" + id;
+        if (booked.count(key) || reservationASM.existsReservation(plate.c_str(), id)) {
+            report.reservations.duplicates++;
+            continue;
+        }
+
+        Vehicle v{};
+        auto vslot = newVehicleSlot.find(plate);
+        if (vslot != newVehicleSlot.end()) v = newVehicles[vslot->second];
+        else if (vehicleASM.findByPlate(plate.c_str(), v) < 0) {
+            reject(report.reservations, row, "vehicle " + plate + " is not registered");
+            continue;
+        }
+
+        SailingRecord* sailing = nullptr;
+        auto sslot = newSailingSlot.find(id);
+        if (sslot != newSailingSlot.end()) {
+            sailing = &newSailings[sslot->second];
+        } else {
+            auto it = changed.find(id);
+            if (it == changed.end()) {
+                SailingRecord stored;
+                if (!sailings.getSailingById(id, stored)) {
+                    reject(report.reservations, row, std::string("sailing ") + id + " does not exist");
+                    continue;
+                }
+                it = changed.emplace(id, stored).first;
+            }
+            sailing = &it->second;
+        }
+
+        char lane = SailingManager::takeLane(*sailing, v.specialHeight, v.specialLength);
+        if (lane == '\0') {
+            reject(report.reservations, row, std::string("not enough lane space on ") + id);
+            continue;
+        }
+        if (onboard) sailing->onboardVehicleCount++;
+
+        ReservationRecord record{};
+        memcpy(record.sailingId, id, DATE_LEN - 1);     // validated: always TTT-DD-HH
+        record.sailingId[DATE_LEN - 1] = '\0';
+        strncpy(record.licensePlate, plate.c_str(), sizeof(record.licensePlate) - 1);
+        record.isOnboard = onboard;
+        record.laneUsed = lane;
+        newReservations.push_back(record);
+        booked.insert(key);
+    }
+
+    //============================
+    // Write: one append per file, one commit for all three
+    //============================
+    if (!sailings.addSailings(newSailings) || !vehicleASM.addRecords(newVehicles)) {
+        return ServiceStatus::STORAGE_ERROR;
+    }
+    for (const auto& entry : changed) {
+        if (!sailings.updateSailing(entry.second)) return ServiceStatus::STORAGE_ERROR;
+    }
+    if (!reservationASM.writeReservationRecords(newReservations)) return ServiceStatus::STORAGE_ERROR;
+    if (!import.commit()) return ServiceStatus::STORAGE_ERROR;
+
+    report.sailings.added = static_cast<int>(newSailings.size());
+    report.vehicles.added = static_cast<int>(newVehicles.size());
+    report.reservations.added = static_cast<int>(newReservations.size());
+    return ServiceStatus::OK;
+}
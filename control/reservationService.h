@@ -0,0 +1,339 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: reservationService.h
+//
+// Headless service layer for the SuperFerry operations: book, check in,
+// cancel, and create/delete sailings and ferries. Nothing here reads
+// std::cin or writes std::cout; every operation validates its input,
+// applies the change (one write-ahead-log commit per operation) and
+// returns a ServiceStatus plus a result struct.
+//
+// The menu flows in ReservationManager, ferryManager and SailingManager
+// are clients of this layer; batch and kiosk integrations can drive it
+// directly.
+//***************************************************
+
+#ifndef RESERVATION_SERVICE_H
+#define RESERVATION_SERVICE_H
+
+#include <string>
+#include <vector>
+#include "../entity/vehicleASM.h"
+#include "../entity/reservationASM.h"
+
+class SailingManager;  // forward declaration
+
+//--------------------------------------
+// Outcome of a service call
+enum class ServiceStatus {
+    OK,
+    INVALID_INPUT,        // malformed plate/phone/size/ID/name
+    NOT_FOUND,            // sailing, ferry, vehicle or reservation missing
+    ALREADY_EXISTS,       // duplicate reservation, sailing or ferry
+    VEHICLE_MISMATCH,     // plate already registered with other phone/size
+    NO_CAPACITY,          // sailing has no lane room for the vehicle
+    ALREADY_CHECKED_IN,
+    IN_USE,               // ferry still assigned to sailings
+    STORAGE_ERROR         // write or commit failed; nothing was changed
+};
+
+//--------------------------------------
+const char* statusText(
+    ServiceStatus status  // in: status to describe
+);
+/*
+Returns a short human-readable description of a status.
+*/
+
+//--------------------------------------
+// Input for createReservation
+struct BookingRequest {
+    std::string licensePlate;   // 1-10 letters/digits/dashes, any case
+    std::string phone;          // 7, 10 or 11 digits; spaces/dashes allowed
+    float height;               // metres, (0, 9.9]; <= 2.0 counts as 2.0
+    float length;               // metres, (0, 99.9]; <= 7.0 counts as 7.0
+    std::string sailingId;      // TTT-DD-HH, any case
+};
+
+//--------------------------------------
+// Output of createReservation
+struct BookingResult {
+    char laneUsed = '\0';           // 'H' or 'L'
+    bool vehicleCreated = false;    // false if an existing vehicle was reused
+    float fare = 0.0f;
+    std::string detail;             // reason for VEHICLE_MISMATCH
+};
+
+//--------------------------------------
+// One reservation as returned by findReservations
+struct ReservationInfo {
+    std::string licensePlate;
+    std::string sailingId;
+    bool isOnboard;
+    char laneUsed;
+};
+
+//--------------------------------------
+// Output of checkIn / getVehicle
+struct VehicleInfo {
+    Vehicle vehicle{};
+    bool isSpecial = false;
+    float fare = 0.0f;
+};
+
+//--------------------------------------
+// Output of cancelReservation
+struct CancelResult {
+    char laneFreed = '\0';      // lane given back, '\0' if the sailing no longer exists
+    bool wasOnboard = false;
+};
+
+//--------------------------------------
+// One row of an import file, split into fields but not yet validated
+struct ImportRow {
+    std::string source;                 // "file:line", used in the report
+    std::vector<std::string> fields;
+};
+
+//--------------------------------------
+// Input for importRecords; columns per kind:
+//   ferries      - name, HCLL, LCLL
+//   sailings     - sailing ID, ferry name
+//   vehicles     - plate, phone, height, length
+//   reservations - plate, sailing ID [, onboard 0/1]
+struct ImportBatch {
+    std::vector<ImportRow> ferries;
+    std::vector<ImportRow> sailings;
+    std::vector<ImportRow> vehicles;
+    std::vector<ImportRow> reservations;
+};
+
+//--------------------------------------
+// Output of importRecords
+struct ImportCounts {
+    int added = 0;
+    int duplicates = 0;     // already on file or earlier in the batch; skipped
+    int rejected = 0;       // failed validation; see ImportReport::problems
+};
+
+struct ImportReport {
+    ImportCounts ferries;
+    ImportCounts sailings;
+    ImportCounts vehicles;
+    ImportCounts reservations;
+    std::vector<std::string> problems;  // "source: reason" per rejected row
+};
+
+class ReservationService {
+private:
+    SailingManager& sailings;
+    VehicleASM& vehicleASM;             // the process-wide handles (storeRegistry.h)
+    ReservationASM& reservationASM;
+
+    int findReservationIndex(const std::string& plate, const std::string& sailingId);
+
+public:
+    //--------------------------------------
+    explicit ReservationService(
+        SailingManager& sm  // in: sailing store shared with the menu
+    );
+
+    //===============================
+    // File Lifecycle Functions
+    //===============================
+
+    //--------------------------------------
+    void initialize();
+    /*
+    Makes sure the data files are open (normally done by start()).
+    */
+
+    //--------------------------------------
+    void shutdown();
+    /*
+    Schedules write-back of the vehicle file. The files themselves stay
+    open in the StoreRegistry until shutdown().
+    */
+
+    //===============================
+    // Reservations
+    //===============================
+
+    //--------------------------------------
+    ServiceStatus createReservation(
+        const BookingRequest& request,  // in: booking details
+        BookingResult& result           // out: lane, fare, vehicle status
+    );
+    /*
+    Validates and normalizes the request, then registers the vehicle (or
+    checks it against the existing record), deducts lane length and
+    writes the reservation as one transaction.
+    */
+
+    //--------------------------------------
+    bool hasReservation(
+        const std::string& licensePlate,  // in: plate (any case)
+        const std::string& sailingId      // in: sailing ID (any case)
+    );
+    /*
+    True if the plate is already booked on the sailing.
+    */
+
+    //--------------------------------------
+    ServiceStatus findReservations(
+        const std::string& licensePlate,      // in: plate (any case)
+        std::vector<ReservationInfo>& out,    // out: reservations on live sailings
+        int* purged = nullptr                 // out (optional): orphans removed
+    );
+    /*
+    Lists the plate's reservations in file order. Reservations whose
+    sailing no longer exists are deleted on the way. Returns NOT_FOUND
+    if the plate had no reservations at all.
+    */
+
+    //--------------------------------------
+    ServiceStatus getVehicle(
+        const std::string& licensePlate,  // in: plate (any case)
+        VehicleInfo& out                  // out: vehicle record and fare
+    );
+    /*
+    Looks up a registered vehicle and its fare.
+    */
+
+    //--------------------------------------
+    ServiceStatus checkIn(
+        const std::string& licensePlate,  // in: plate (any case)
+        const std::string& sailingId,     // in: sailing ID (any case)
+        VehicleInfo* vehicle = nullptr    // out (optional): vehicle and fare
+    );
+    /*
+    Marks the reservation onboard and increments the sailing's onboard
+    count.
+    */
+
+    //--------------------------------------
+    ServiceStatus cancelReservation(
+        const std::string& licensePlate,  // in: plate (any case)
+        const std::string& sailingId,     // in: sailing ID (any case)
+        CancelResult& result              // out: lane restored, onboard flag
+    );
+    /*
+    Deletes the reservation, gives the lane length back to the lane
+    recorded at booking and decrements the onboard count if it had
+    checked in. Nothing changes if the lane cannot be given back:
+    STORAGE_ERROR if the sailing could not be written, NOT_FOUND if
+    the vehicle is no longer registered.
+    */
+
+    //--------------------------------------
+    std::vector<ReservationInfo> listReservations();
+    /*
+    Every reservation in file order (reporting/debug).
+    */
+
+    //--------------------------------------
+    std::vector<Vehicle> listVehicles();
+    /*
+    Every registered vehicle in file order (reporting/debug).
+    */
+
+    //===============================
+    // Sailings and Ferries
+    //===============================
+
+    //--------------------------------------
+    ServiceStatus createSailing(
+        const std::string& sailingId,  // in: TTT-DD-HH (any case)
+        const std::string& ferryName   // in: existing ferry (any case)
+    );
+    /*
+    Adds a sailing with the ferry's full lane capacities.
+    */
+
+    //--------------------------------------
+    ServiceStatus deleteSailing(
+        const std::string& sailingId  // in: sailing ID (any case)
+    );
+    /*
+    Deletes a sailing and every reservation on it.
+    */
+
+    //--------------------------------------
+    ServiceStatus createFerry(
+        const std::string& ferryName,  // in: 1-25 chars, stored uppercase
+        int HCLL,                      // in: high ceiling lane length, 0-3600
+        int LCLL                       // in: low ceiling lane length, 0-3600
+    );
+    /*
+    Adds a ferry. At least one lane length must be non-zero.
+    */
+
+    //--------------------------------------
+    ServiceStatus deleteFerry(
+        const std::string& ferryName,              // in: ferry name (any case)
+        std::vector<std::string>* assignedSailings = nullptr // out (optional): blockers
+    );
+    /*
+    Deletes a ferry. Returns IN_USE (and the sailing IDs) if any sailing
+    still uses it.
+    */
+
+    //===============================
+    // Bulk Import
+    //===============================
+
+    //--------------------------------------
+    ServiceStatus importRecords(
+        const ImportBatch& batch,  // in: rows of each kind
+        ImportReport& report       // out: per-kind counts and rejected rows
+    );
+    /*
+    Validates every row with the same rules as the single-record calls,
+    drops duplicates in memory, and appends each record file in one
+    write. Reservations take lane space and onboard counts from their
+    sailings (earlier rows first). Ferries are committed first; the
+    other three files are written as one transaction. Rejected rows do
+    not stop the import; only STORAGE_ERROR does.
+    */
+
+    //===============================
+    // Validation Helpers
+    //===============================
+
+    //--------------------------------------
+    static float calculateFare(
+        const Vehicle& v  // in: vehicle to price
+    );
+    /*
+    Regular (<= 2.0 m high, <= 7.0 m long): $14; over-height: $3/m of
+    length; over-length only: $2/m.
+    */
+
+    //--------------------------------------
+    static std::string normalizePhoneNumber(
+        const std::string& raw  // in: phone as typed
+    );
+    /*
+    7/10/11 digits -> xxx-xxxx / xxx-xxx-xxxx / x-xxx-xxx-xxxx.
+    Returns "" if invalid.
+    */
+
+    //--------------------------------------
+    static bool normalizeLicensePlate(
+        std::string& plate  // in/out: validated and uppercased
+    );
+    /*
+    1-10 letters, digits or dashes. Returns false if invalid.
+    */
+
+    //--------------------------------------
+    static bool normalizeDimensions(
+        float& height,  // in/out: rounded up to 0.1 m, at least 2.0 m
+        float& length   // in/out: rounded up to 0.1 m, at least 7.0 m
+    );
+    /*
+    Returns false if outside (0, 9.9] x (0, 99.9].
+    */
+};
+
+#endif // RESERVATION_SERVICE_H
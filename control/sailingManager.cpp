@@ -24,19 +24,95 @@
 #include <cstring>
 #include <iostream>
 #include <iomanip>
-#include "../entity/reservationASM.h"
-#include "../entity/ferryASM.h"
+#include <limits>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include "../entity/storeRegistry.h"
+#include "../system/ioTrace.h"
+#include "../system/latencyStats.h"
+#include "../system/writeAheadLog.h"
 
 using namespace std;
 
+//--------------------------------------
+SailingManager::SailingManager()
+    : db(StoreRegistry::sailings()) {}
+
 //--------------------------------------
 void SailingManager::initialize() {
-    db.initialize();
+    StoreRegistry::openAll();
+    // check-in and cancel keep the counts current; they only need a
+    // recount when the files changed under them or no longer add up
+    if (StoreRegistry::takeRecovery() || !onboardCountsConsistent()) {
+        rebuildOnboardCounts();
+    }
+}
+
+//--------------------------------------
+// Cheap check of the stored counts against the other files: no sailing
+// with more vehicles on board than there are registered vehicles, and
+// no more on board in total than there are reservations.
+// One pass over the sailings, none over reservations.dat.
+bool SailingManager::onboardCountsConsistent() {
+    long long onboard = 0;
+    int vehicles = StoreRegistry::vehicles().getRecordCount();
+    int count = db.getRecordCount();
+    for (int i = 0; i < count; ++i) {
+        SailingRecord r;
+        if (!db.getRecord(i, r)) return false;
+        if (r.onboardVehicleCount > vehicles) return false;
+        onboard += r.onboardVehicleCount;
+    }
+    return onboard <= StoreRegistry::reservations().getRecordCount();
+}
+
+//--------------------------------------
+// One pass over reservations.dat to make every sailing's stored
+// onboardVehicleCount equal its number of checked-in reservations.
+// Older data files counted reservations at booking time instead.
+void SailingManager::rebuildOnboardCounts() {
+    static LatencyProbe latencyProbe("sailingManager.rebuildOnboardCounts");
+    LatencyTimer timer(latencyProbe);
+    // other booths may be checking in meanwhile: hold the sailings
+    // (before the reservations, as everywhere) while counting
+    if (!db.lockAll()) {
+        cerr << "[WARN] Could not lock the sailings; onboard counts not rebuilt." << endl;
+        WriteAheadLog::commit();    // releases whatever was locked
+        return;
+    }
+    int count = db.getRecordCount();
+    if (count == 0) {
+        WriteAheadLog::commit();
+        return;
+    }
+
+    std::vector<int> onboard(count, 0);
+
+    std::unordered_map<int, int> perSailing;
+    StoreRegistry::reservations().tallyOnboard(perSailing);
+
+    for (const auto& entry : perSailing) {
+        char id[DATE_LEN];
+        SailingASM::unpackSailingId(entry.first, id);
+        int slot = db.findIndexById(id);
+        if (slot >= 0) onboard[slot] += entry.second;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        SailingRecord r;
+        if (db.getRecord(i, r) && r.onboardVehicleCount != onboard[i]) {
+            r.onboardVehicleCount = onboard[i];
+            if (!db.updateRecord(i, r))
+                cerr << "[WARN] Could not correct the onboard count of sailing " << r.date << endl;
+        }
+    }
+    WriteAheadLog::commit();    // also releases the lock
 }
 
 //--------------------------------------
 void SailingManager::close() {
-    db.shutdown();
+    db.flush();
 }
 
 //--------------------------------------
@@ -45,11 +121,12 @@ void SailingManager::deleteAllSailings() {
     for (int i = count - 1; i >= 0; --i) {
         db.deleteRecord(i);
     }
-    db.flush();
+    WriteAheadLog::commit();
 }
 
 //--------------------------------------
 void SailingManager::printAllSailings() {
+    IoFlow ioFlow("printAllSailings");
     const int PAGE_SIZE = 5;
     int totalRecords = db.getRecordCount();
 
@@ -90,17 +167,7 @@ void SailingManager::printAllSailings() {
         cout << "\n" << endl; // Spacing
 
         // Rows
-        for (int i = start; i < end; ++i) {
-            SailingRecord r;
-            if (db.getRecord(i, r)) {
-                int onboard = getOnboardVehicleCount(r.date);
-                cout << right << setw(4) << (i + 1) << "  " << left << setw(12) << r.date
-                     << left << setw(28) << r.ferryName
-                     << left << setw(8) << fixed << setprecision(1) << r.highLaneRestLength
-                     << left << setw(8) << fixed << setprecision(1) << r.lowLaneRestLength
-                     << left << setw(4) << onboard << "\n";
-            }
-        }
+        renderReportRows(cout, start, end);
 
         cout << "==========================================================================\n";
         cout << "[Page " << (currentPage + 1) << " of " << totalPages << "]\n";
@@ -139,6 +206,23 @@ void SailingManager::printAllSailings() {
 
 
 
+//--------------------------------------
+void SailingManager::renderReportRows(ostream& out, int start, int end) {
+    static LatencyProbe latencyProbe("sailingManager.renderReportRows");
+    LatencyTimer timer(latencyProbe);
+    for (int i = start; i < end; ++i) {
+        SailingRecord r;
+        if (db.getRecord(i, r)) {
+            int onboard = r.onboardVehicleCount;
+            out << right << setw(4) << (i + 1) << "  " << left << setw(12) << r.date
+                << left << setw(28) << r.ferryName
+                << left << setw(8) << fixed << setprecision(1) << toMetres(r.highLaneRestDm)
+                << left << setw(8) << fixed << setprecision(1) << toMetres(r.lowLaneRestDm)
+                << left << setw(4) << onboard << "\n";
+        }
+    }
+}
+
 //--------------------------------------
 int SailingManager::getSailingCount() {
     return db.getRecordCount();
@@ -151,145 +235,163 @@ bool SailingManager::getSailingByIndex(int index, SailingRecord& out) {
 
 //--------------------------------------
 bool SailingManager::sailingExists(const char* date) {
-    int count = db.getRecordCount();
-    SailingRecord r;
-    for (int i = 0; i < count; ++i) {
-        if (db.getRecord(i, r) && strcmp(r.date, date) == 0) return true;
-    }
-    return false;
+    return db.findIndexById(date) >= 0;
+}
+
+//--------------------------------------
+bool SailingManager::ferryInUse(const char* ferryName) {
+    return db.ferryInUse(ferryName);
+}
+
+//--------------------------------------
+std::vector<int> SailingManager::getSailingsWithFerry(const char* ferryName) {
+    return db.findSailingsWithFerry(ferryName);
 }
 
 //--------------------------------------
 bool SailingManager::addSailing(const SailingRecord& record) {
-    if (sailingExists(record.date)) {
-        cout << "Sailing already exists for date: " << record.date << endl;
-        return false;
-    }
-    db.addRecord(record);
-    db.flush();
+    static LatencyProbe latencyProbe("sailingManager.addSailing");
+    LatencyTimer timer(latencyProbe);
+    if (sailingExists(record.date)) return false;
+    if (!db.addRecord(record)) return false;
+    WriteAheadLog::commit();
     return true;
 }
 
 //--------------------------------------
-bool SailingManager::deleteSailingByDate(const char* date) {
-    int count = db.getRecordCount();
-    SailingRecord r;
+bool SailingManager::addSailings(const std::vector<SailingRecord>& records) {
+    static LatencyProbe latencyProbe("sailingManager.addSailings");
+    LatencyTimer timer(latencyProbe);
+    return db.addRecords(records);
+}
 
-    for (int i = 0; i < count; ++i) {
-        if (db.getRecord(i, r) && strcmp(r.date, date) == 0) {
+//--------------------------------------
+bool SailingManager::getSailingById(const char* date, SailingRecord& out) {
+    int i = db.findIndexById(date);
+    return i >= 0 && db.getRecord(i, out);
+}
 
-            // --- 先：静默清理所有与该航次绑定的预约（包含已 check-in 的） ---
-            ReservationASM resASM;
-            resASM.initialize();
+//--------------------------------------
+bool SailingManager::updateSailing(const SailingRecord& record) {
+    static LatencyProbe latencyProbe("sailingManager.updateSailing");
+    LatencyTimer timer(latencyProbe);
+    int i = db.lockIndexById(record.date);
+    if (i < 0) return false;
+    return db.updateRecord(i, record);
+}
 
-            // 反复扫描删除，直到没有匹配项（更稳妥，避免漏删）
-            while (true) {
-                bool deletedOne = false;
-                int rc = resASM.getRecordCount();
-                for (int j = rc - 1; j >= 0; --j) {
-                    ReservationRecord rr = resASM.get(j);
-                    if (strcmp(rr.sailingId, date) == 0) {
-                        resASM.deleteReservationByIndex(j); // 忽略返回值，继续删
-                        deletedOne = true;
-                        // 不在这里 break；倒序可安全继续
-                    }
-                }
-                if (!deletedOne) break;
-            }
+//--------------------------------------
+bool SailingManager::deleteSailingByDate(const char* date) {
+    static LatencyProbe latencyProbe("sailingManager.deleteSailingByDate");
+    LatencyTimer timer(latencyProbe);
+    IoFlow ioFlow("sailingManager.deleteSailingByDate");
+    // the row and its reservations go in one transaction, so a crash
+    // cannot leave reservations behind on a sailing that is gone
+    Transaction removal;
+    int i = db.lockIndexById(date);
+    SailingRecord r;
+    if (i < 0 || !db.getRecord(i, r)) return false;
 
-            resASM.shutdown();
+    // sailing first, then its reservations: the order every operation locks in;
+    // if either fails, returning discards both
+    if (!db.deleteRecord(i)) return false;
 
-            // --- 后：删除该航次本体 ---
-            db.deleteRecord(i);
-            db.flush();
-            return true;
-        }
-    }
-    return false;
+    // 静默清理所有与该航次绑定的预约（包含已 check-in 的）
+    // 单次流式扫描：幸存记录原地前移，文件只截断一次
+    if (StoreRegistry::reservations().deleteBySailing(date) < 0) return false;
+
+    return removal.commit();
 }
 
 
 
 //--------------------------------------
-int SailingManager::getMatchingSailings(float height, float length, SailingRecord* outArray, int maxCount) {
-    int total = 0;
-    int count = db.getRecordCount();
-    SailingRecord r;
-
-    for (int i = 0; i < count && total < maxCount; ++i) {
-        if (db.getRecord(i, r)) {
-            bool isTall = (height > 2.0f);
-            bool canFit = false;
-
-            if (isTall) {
-                if (r.highLaneRestLength >= length) canFit = true;
-            } else {
-                if (r.lowLaneRestLength >= length || r.highLaneRestLength >= length) canFit = true;
-            }
+int SailingManager::getMatchingSailings(float height, float length,
+                                        const std::function<bool(const SailingRecord&)>& visit) {
+    static LatencyProbe latencyProbe("sailingManager.getMatchingSailings");
+    LatencyTimer timer(latencyProbe);
+    return db.forEachWithRoom(height, length, [&](int slot) {
+        SailingRecord r;
+        return !db.getRecord(slot, r) || visit(r);
+    });
+}
 
-            if (canFit) {
-                outArray[total++] = r;
-            }
-        }
+//--------------------------------------
+int SailingManager::getMatchingSailings(float height, float length, std::vector<SailingRecord>& out) {
+    // collect slots first so the list keeps the file order the menu always showed
+    std::vector<int> slots;
+    db.forEachWithRoom(height, length, [&](int slot) {
+        slots.push_back(slot);
+        return true;
+    });
+    std::sort(slots.begin(), slots.end());
+
+    out.clear();
+    out.reserve(slots.size());
+    for (int slot : slots) {
+        SailingRecord r;
+        if (db.getRecord(slot, r)) out.push_back(r);
     }
-    return total;
+    return static_cast<int>(out.size());
 }
 
 //--------------------------------------
-int SailingManager::getSailingsByPage(
-    const SailingRecord* matchList, int matchCount,
-    int pageNum, int pageSize,
-    SailingRecord* outArray
-) {
-    int start = pageNum * pageSize;
-    int end = start + pageSize;
-    if (start >= matchCount) return 0;
-
-    int actual = 0;
-    for (int i = start; i < end && i < matchCount; ++i) {
-        outArray[actual++] = matchList[i];
-    }
-    return actual;
+RecordCursor<SailingRecord> SailingManager::matchingSailings(float height, float length, int pageSize) {
+    std::shared_ptr<std::vector<int>> slots = std::make_shared<std::vector<int>>();
+    db.forEachWithRoom(height, length, [&](int slot) {
+        slots->push_back(slot);
+        return true;
+    });
+    std::sort(slots->begin(), slots->end());
+
+    return RecordCursor<SailingRecord>(
+        [slots] { return static_cast<int>(slots->size()); },
+        [this, slots](int i, SailingRecord& out) { return db.getRecord((*slots)[i], out); },
+        pageSize);
 }
 
 //--------------------------------------
-const char* SailingManager::showAvailableAndSelect(
-    const SailingRecord* matchList, int matchCount,
-    int pageSize
-) {
-    int currentPage = 0;
-    char command;
+bool SailingManager::showAvailableAndSelect(RecordCursor<SailingRecord>& matches, char selectedId[DATE_LEN]) {
+    string command;
 
     while (true) {
-        int start = currentPage * pageSize;
-        int end = (start + pageSize < matchCount) ? (start + pageSize) : matchCount;
+        const vector<SailingRecord>& page = matches.records();
 
         cout << "\n================== Available Sailings ==================" << endl;
-        for (int i = start; i < end; ++i) {
-            cout << (i - start + 1) << ". "
-                 << matchList[i].date << "\t"
-                 << "HRL: " << fixed << setprecision(1) << matchList[i].highLaneRestLength << " m\t"
-                 << "LRL: " << matchList[i].lowLaneRestLength << " m" << endl;
+        for (size_t i = 0; i < page.size(); ++i) {
+            cout << (i + 1) << ". "
+                 << page[i].date << "\t"
+                 << "HRL: " << fixed << setprecision(1) << toMetres(page[i].highLaneRestDm) << " m\t"
+                 << "LRL: " << toMetres(page[i].lowLaneRestDm) << " m" << endl;
         }
-        cout << "[Results " << (start + 1) << " to " << end << " of " << matchCount << "]\n";
-        cout << "Select [1~" << (end - start)
+        cout << "[Results " << (matches.first() + 1) << " to " << matches.last() << " of " << matches.total() << "]\n";
+        cout << "Select [1~" << page.size()
              << "], or type 'n' (next), 'p' (prev), or 'q' (quit): ";
 
-        cin >> command;
-
-        if (command == 'n') {
-            if ((currentPage + 1) * pageSize < matchCount) currentPage++;
-        } else if (command == 'p') {
-            if (currentPage > 0) currentPage--;
-        } else if (command == 'q') {
-            return "";
-        } else if (isdigit(static_cast<unsigned char>(command))) {
-            int selection = command - '0';
-            if (selection >= 1 && selection <= (end - start)) {
-                return matchList[start + selection - 1].date;
+        if (!(cin >> command)) return false;
+
+        int selection = 0;
+        switch (parsePageCommand(command, selection)) {
+            case PageCommand::NEXT:
+                matches.next();
+                break;
+            case PageCommand::PREV:
+                matches.prev();
+                break;
+            case PageCommand::QUIT:
+                return false;
+            case PageCommand::SELECT: {
+                SailingRecord chosen;
+                if (matches.pick(selection, chosen)) {
+                    memcpy(selectedId, chosen.date, DATE_LEN);
+                    selectedId[DATE_LEN - 1] = '\0';
+                    return true;
+                }
+                break;
             }
-        } else {
-            cout << "Invalid input." << endl;
+            default:
+                cout << "Invalid input." << endl;
+                break;
         }
         cin.clear();
         cin.ignore(numeric_limits<streamsize>::max(), '\n');
@@ -298,7 +400,8 @@ const char* SailingManager::showAvailableAndSelect(
 
 //--------------------------------------
 void SailingManager::createSailingViaUI() {
-    SailingRecord record;
+    IoFlow ioFlow("createSailingViaUI");
+    SailingRecord record{};
     cout << "\n==== Create New Sailing ====" << endl;
 
     // 输入并验证 Sailing ID
@@ -331,38 +434,46 @@ void SailingManager::createSailingViaUI() {
 
     strncpy(record.ferryName, selectedFerry.ferryName, NAME_LEN);
     record.ferryName[NAME_LEN - 1] = '\0'; // terminate string
-    record.highLaneRestLength = selectedFerry.HCLL;
-    record.lowLaneRestLength = selectedFerry.LCLL;
+    record.highLaneRestDm = selectedFerry.HCLL * 10;
+    record.lowLaneRestDm = selectedFerry.LCLL * 10;
 
     if (addSailing(record)) {
+        cout << "Sailing record written successfully." << endl;
         cout << "\n-----------------------------------" << endl;
         cout << "Ferry Name:\t\t" << record.ferryName << endl;
-        cout << "High Ceiling Lane:\t" << record.highLaneRestLength << endl;
-        cout << "Low Ceiling Lane:\t" << record.lowLaneRestLength << endl;
+        cout << "High Ceiling Lane:\t" << toMetres(record.highLaneRestDm) << endl;
+        cout << "Low Ceiling Lane:\t" << toMetres(record.lowLaneRestDm) << endl;
         cout << "-----------------------------------\n" << endl;
     }
-    else
+    else {
+        cout << "Sailing already exists for date: " << record.date << endl;
         cout << "Failed to create sailing (duplicate date)." << endl;
+    }
 }
 
 //--------------------------------------
 void SailingManager::deleteSailingViaUI() {
+    IoFlow ioFlow("deleteSailingViaUI");
     const int pageSize = 5;
-    int currentPage = 0;
     string input;
 
+    // the page is read once per move/delete, not on every prompt
+    RecordCursor<SailingRecord> cursor(
+        [this] { return db.getRecordCount(); },
+        [this](int i, SailingRecord& out) { return db.getRecord(i, out); },
+        pageSize);
+
     // ⚠️ 移除多余的 cin.ignore，避免需要多按一次回车
     // cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
     while (true) {
-        int total = db.getRecordCount();
-        if (total == 0) {
+        if (cursor.total() == 0) {
             cout << "\n[Info] No sailings available in the system.\n" << endl;
 
             string input2;
             while (true) {
                 cout << "Enter 'q' to return to Main Menu: ";
-                getline(cin, input2);
+                if (!getline(cin, input2)) return;
                 if (input2 == "q" || input2 == "Q") {
                     cout << "Returning to Main Menu...\n";
                     return;
@@ -372,65 +483,58 @@ void SailingManager::deleteSailingViaUI() {
             }
         }
 
-        int start = currentPage * pageSize;
-        int end = min(start + pageSize, total);
+        const vector<SailingRecord>& page = cursor.records();
 
         cout << "\n==== Delete Sailing ====" << endl;
-        for (int i = start; i < end; ++i) {
-            SailingRecord r;
-            if (db.getRecord(i, r)) {
-                cout << (i - start + 1) << ". " << r.date << "\t"
-                     << "HRL: " << fixed << setprecision(1) << r.highLaneRestLength << " m\t"
-                     << "LRL: " << r.lowLaneRestLength << " m" << endl;
-            }
+        for (size_t i = 0; i < page.size(); ++i) {
+            const SailingRecord& r = page[i];
+            cout << (i + 1) << ". " << r.date << "\t"
+                 << "HRL: " << fixed << setprecision(1) << toMetres(r.highLaneRestDm) << " m\t"
+                 << "LRL: " << toMetres(r.lowLaneRestDm) << " m" << endl;
         }
 
-        cout << "\n[Page " << (currentPage + 1) << "] Select 1~" << (end - start)
+        cout << "\n[Page " << (cursor.page() + 1) << "] Select 1~" << page.size()
              << ", 'n'=next, 'p'=prev, 'q'=quit: ";
         cin >> ws;
-        getline(cin, input);
-
-        if (input == "n") {
-            if ((currentPage + 1) * pageSize < total) currentPage++;
-            else cout << "[Info] This is the last page.\n";
-        } else if (input == "p") {
-            if (currentPage > 0) currentPage--;
-            else cout << "[Info] This is the first page.\n";
-        } else if (input == "q") {
+        if (!getline(cin, input)) return;
+
+        int selection = 0;
+        PageCommand command = parsePageCommand(input, selection);
+        if (command == PageCommand::NEXT) {
+            if (!cursor.next()) cout << "[Info] This is the last page.\n";
+        } else if (command == PageCommand::PREV) {
+            if (!cursor.prev()) cout << "[Info] This is the first page.\n";
+        } else if (command == PageCommand::QUIT) {
             cout << "Returning to Main Menu...\n";
             break;
-        } else if (input.length() == 1 && isdigit(static_cast<unsigned char>(input[0]))) {
-            int selection = input[0] - '0';
-            if (selection >= 1 && selection <= (end - start)) {
-                SailingRecord r;
-                if (db.getRecord(start + selection - 1, r)) {
-                    // 显示用户选择的 sailing 信息
-                    cout << "\nYou selected to delete sailing:\n";
-                    cout << "Date: " << r.date
-                         << ", HRL: " << fixed << setprecision(1) << r.highLaneRestLength << " m"
-                         << ", LRL: " << r.lowLaneRestLength << " m" << endl;
-
-                    // 确认删除
-                    string confirmInput;
-                    while (true) {
-                        cout << "\n> Confirm delete? [1] Confirm  [2] Cancel: ";
-                        getline(cin, confirmInput);
-
-                        if (confirmInput == "1") {
-                            if (deleteSailingByDate(r.date)) {
-                                cout << "Sailing deleted: " << r.date << endl;
-                                if ((currentPage * pageSize) >= db.getRecordCount() && currentPage > 0)
-                                    currentPage--;
-                            } else {
-                                cout << "[Error] Failed to delete sailing.\n";
-                            }
-                            break;
-                        } else if (confirmInput == "2") {
-                            cout << "Deletion cancelled.\n";
-                            break;
+        } else if (command == PageCommand::SELECT) {
+            SailingRecord r;
+            if (cursor.pick(selection, r)) {
+                // 显示用户选择的 sailing 信息
+                cout << "\nYou selected to delete sailing:\n";
+                cout << "Date: " << r.date
+                     << ", HRL: " << fixed << setprecision(1) << toMetres(r.highLaneRestDm) << " m"
+                     << ", LRL: " << toMetres(r.lowLaneRestDm) << " m" << endl;
+
+                // 确认删除
+                string confirmInput;
+                while (true) {
+                    cout << "\n> Confirm delete? [1] Confirm  [2] Cancel: ";
+                    if (!getline(cin, confirmInput)) return;
+
+                    if (confirmInput == "1") {
+                        if (deleteSailingByDate(r.date)) {
+                            cout << "Sailing deleted: " << r.date << endl;
+                            cursor.refresh();   // re-count and step back if the page emptied
                         } else {
-                            cout << "[Error] Invalid input. Please enter 1 to confirm or 2 to cancel.\n";
+                            cout << "[Error] Failed to delete sailing.\n";
                         }
+                        break;
+                    } else if (confirmInput == "2") {
+                        cout << "Deletion cancelled.\n";
+                        break;
+                    } else {
+                        cout << "[Error] Invalid input. Please enter 1 to confirm or 2 to cancel.\n";
                     }
                 }
             } else {
@@ -464,95 +568,121 @@ char SailingManager::updateLaneLengths(const char* date, float height, float len
         cout << "Error: Invalid vehicle dimensions. Height must be (0, 9.9], Length must be (0, 99.9]" << endl;
         return '\0';
     }
+    if (!sailingExists(date)) {
+        cout << "Error: Sailing not found for date " << date << endl;
+        return '\0';
+    }
 
-    int count = db.getRecordCount();
-    for (int i = 0; i < count; ++i) {
-        SailingRecord r;
-        if (!(db.getRecord(i, r) && strcmp(r.date, date) == 0)) continue;
+    if (isReversing) {
+        if (!releaseLane(date, length, laneHint)) {
+            cout << "Error: Invalid lane hint when freeing capacity (need 'H' or 'L').\n";
+            return '\0';
+        }
+        return laneHint;
+    }
 
-        if (isReversing) {
-            // ----- restore capacity to exact lane -----
-            if (laneHint != 'H' && laneHint != 'L') {
-                cout << "Error: Invalid lane hint when freeing capacity (need 'H' or 'L').\n";
-                return '\0';
-            }
-            if (laneHint == 'H') r.highLaneRestLength += length;
-            else                r.lowLaneRestLength  += length;
+    char lane = allocateLane(date, height, length);
+    if (lane == '\0') {
+        if (height > 2.0f)
+            cout << "Error: Not enough HRL space for tall vehicle on sailing " << date << endl;
+        else
+            cout << "Error: Not enough space for this vehicle on sailing " << date << endl;
+    }
+    return lane;
+}
 
-            db.updateRecord(i, r);
-            db.flush();
-            return laneHint;
-        } else {
-            // ----- allocate capacity; choose lane deterministically -----
-            bool isTall = (height > 2.0f);
-            if (isTall) {
-                // tall vehicles must use H
-                if (r.highLaneRestLength >= length) {
-                    r.highLaneRestLength -= length;
-                    db.updateRecord(i, r);
-                    db.flush();
-                    return 'H';
-                } else {
-                    cout << "Error: Not enough HRL space for tall vehicle on sailing " << date << endl;
-                    return '\0';
-                }
-            } else {
-                // regular: prefer L, fallback H
-                if (r.lowLaneRestLength >= length) {
-                    r.lowLaneRestLength -= length;
-                    db.updateRecord(i, r);
-                    db.flush();
-                    return 'L';
-                } else if (r.highLaneRestLength >= length) {
-                    r.highLaneRestLength -= length;
-                    db.updateRecord(i, r);
-                    db.flush();
-                    return 'H';
-                } else {
-                    cout << "Error: Not enough space for this vehicle on sailing " << date << endl;
-                    return '\0';
-                }
-            }
-        }
+//--------------------------------------
+// Silent allocation used by updateLaneLengths and ReservationService
+char SailingManager::allocateLane(const char* date, float height, float length) {
+    static LatencyProbe latencyProbe("sailingManager.allocateLane");
+    LatencyTimer timer(latencyProbe);
+    int i = db.lockIndexById(date);
+    SailingRecord r;
+    if (i < 0 || !db.getRecord(i, r)) return '\0';
+
+    char lane = takeLane(r, height, length);
+    if (lane == '\0') return '\0';
+
+    // the lane is only handed out once its capacity is deducted
+    if (!db.updateRecord(i, r)) return '\0';
+    return lane;
+}
+
+//--------------------------------------
+bool SailingManager::lockSailing(const char* date) {
+    return db.lockIndexById(date) >= 0;
+}
+
+//--------------------------------------
+bool SailingManager::lockAllSailings() {
+    return db.lockAll();
+}
+
+//--------------------------------------
+// Lane rule on an in-memory record (shared with bulk import)
+char SailingManager::takeLane(SailingRecord& r, float height, float length) {
+    // choose lane deterministically
+    char lane = '\0';
+    bool isTall = (height > 2.0f);
+    int needed = toDecimetres(length);
+    if (isTall) {
+        // tall vehicles must use H
+        if (r.highLaneRestDm >= needed) lane = 'H';
+    } else {
+        // regular: prefer L, fallback H
+        if (r.lowLaneRestDm >= needed)       lane = 'L';
+        else if (r.highLaneRestDm >= needed) lane = 'H';
     }
 
-    cout << "Error: Sailing not found for date " << date << endl;
-    return '\0';
+    if (lane == 'H') r.highLaneRestDm -= needed;
+    else if (lane == 'L') r.lowLaneRestDm -= needed;
+    return lane;
 }
 
 //--------------------------------------
-int SailingManager::getOnboardVehicleCount(const char* sailingID) {
-    ReservationASM reservationASM;
-    reservationASM.initialize();
+// Silent restore of capacity to the exact lane
+bool SailingManager::releaseLane(const char* date, float length, char lane) {
+    static LatencyProbe latencyProbe("sailingManager.releaseLane");
+    LatencyTimer timer(latencyProbe);
+    if (lane != 'H' && lane != 'L') return false;
 
-    int total = reservationASM.getRecordCount();
-    int onboardCount = 0;
+    int i = db.lockIndexById(date);
+    SailingRecord r;
+    if (i < 0 || !db.getRecord(i, r)) return false;
 
-    for (int i = 0; i < total; i++) {
-        ReservationRecord rec = reservationASM.get(i);
-        if (strcmp(rec.sailingId, sailingID) == 0 && rec.isOnboard) {
-            onboardCount++;
-        }
+    if (lane == 'H') r.highLaneRestDm += toDecimetres(length);
+    else             r.lowLaneRestDm  += toDecimetres(length);
+
+    if (!db.updateRecord(i, r)) {
+        cerr << "[ERROR] Could not give lane capacity back to sailing " << date << endl;
+        return false;
     }
+    return true;
+}
 
-    reservationASM.shutdown();
-    return onboardCount;
+//--------------------------------------
+int SailingManager::getOnboardVehicleCount(const char* sailingID) {
+    int i = db.findIndexById(sailingID);
+    SailingRecord r;
+    if (i < 0 || !db.getRecord(i, r)) return 0;
+    return r.onboardVehicleCount;
 }
 
 //--------------------------------------
-void SailingManager::updateOnboardCount(const char* date, int delta) {
-    int count = db.getRecordCount();
-    for (int i = 0; i < count; ++i) {
-        SailingRecord r;
-        if (db.getRecord(i, r) && strcmp(r.date, date) == 0) {
-            r.onboardVehicleCount += delta;
-            if (r.onboardVehicleCount < 0) r.onboardVehicleCount = 0;
-            db.updateRecord(i, r);
-            db.flush();
-            return;
-        }
+bool SailingManager::updateOnboardCount(const char* date, int delta) {
+    int i = db.lockIndexById(date);
+    SailingRecord r;
+    if (i < 0 || !db.getRecord(i, r)) {
+        cout << "WARN: Sailing not found for date " << date << endl;
+        return false;
+    }
+    r.onboardVehicleCount += delta;
+    if (r.onboardVehicleCount < 0) r.onboardVehicleCount = 0;
+    if (!db.updateRecord(i, r)) {
+        cerr << "[ERROR] Could not update the onboard count of sailing " << date << endl;
+        return false;
     }
-    cout << "WARN: Sailing not found for date " << date << endl;
+    return true;
 }
 
 //--------------------------------------
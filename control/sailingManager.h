@@ -18,19 +18,48 @@
 
 #include "../entity/sailingASM.h"
 #include "../entity/vehicleASM.h"
+#include "../entity/recordCursor.h"
+#include <iosfwd>
+#include <functional>
 
 class SailingManager {
 private:
-    SailingASM db;
+    SailingASM& db;     // the process-wide handle (storeRegistry.h)
 
 public:
+    //--------------------------------------
+    SailingManager();
+    /*
+    Binds to the sailing handle of the StoreRegistry.
+    */
+
     //--------------------------------------
     void initialize();
     /*
-    Initializes internal sailing data source (sailingASM).
+    Makes sure the data files are open (normally done by start()) and
+    recounts the onboard vehicles if start() replayed the log or
+    migrated a file, or the stored counts fail onboardCountsConsistent().
     Must be called before any other operation.
     */
 
+    //--------------------------------------
+    void rebuildOnboardCounts();
+    /*
+    Recomputes every sailing's onboardVehicleCount from the checked-in
+    reservations. Called by initialize() when needed; otherwise the
+    count is kept current by check-in and delete flows.
+    */
+
+    //--------------------------------------
+    bool onboardCountsConsistent();
+    /*
+    True if no stored count exceeds the number of registered vehicles
+    and together they do not exceed the number of reservations (one pass
+    over the sailings). Stored counts are unsigned, so only the upper
+    bound can be checked; a replay or migration is caught by
+    StoreRegistry::takeRecovery() instead.
+    */
+
     //--------------------------------------
     void deleteAllSailings();
     /*
@@ -44,6 +73,17 @@ public:
     Prints all sailings to the console.
     */
 
+    //--------------------------------------
+    void renderReportRows(
+        std::ostream& out,  // in/out: stream to write the rows to
+        int start,          // in: first record index
+        int end             // in: one past the last record index
+    );
+    /*
+    Writes the sailing report rows [start, end) in the report's column
+    layout. Used by printAllSailings for each page and by the benchmark.
+    */
+
     //--------------------------------------
     int getSailingCount();
     /*
@@ -63,7 +103,8 @@ public:
     //--------------------------------------
     void close();
     /*
-    Closes the sailingASM file and releases resources.
+    Schedules write-back of the sailing file. The file itself stays
+    open in the StoreRegistry until shutdown().
     */
 
     //--------------------------------------
@@ -74,13 +115,57 @@ public:
     Checks if a sailing with the given ID exists.
     */
 
+    //--------------------------------------
+    bool ferryInUse(
+        const char* ferryName  // in: ferry name to check
+    );
+    /*
+    Returns true if any sailing is assigned to the ferry (indexed lookup).
+    */
+
+    //--------------------------------------
+    std::vector<int> getSailingsWithFerry(
+        const char* ferryName  // in: ferry name to look up
+    );
+    /*
+    Returns the indexes of the sailings assigned to the ferry, for use
+    with getSailingByIndex(). Empty if the ferry is unused.
+    */
+
     //--------------------------------------
     bool addSailing(
         const SailingRecord& record  // in: new sailing record to add
     );
     /*
-    Adds a new sailing to the data store.
-    Returns true on success.
+    Adds a new sailing to the data store (no console output).
+    Returns false if the ID is already taken or the write fails.
+    */
+
+    //--------------------------------------
+    bool addSailings(
+        const std::vector<SailingRecord>& records  // in: new sailings, IDs unique and unused
+    );
+    /*
+    Bulk form of addSailing for import: appends every record in one
+    write. Does not commit; the caller owns the transaction.
+    */
+
+    //--------------------------------------
+    bool getSailingById(
+        const char* date,     // in: sailing ID (format: TTT-DD-HH)
+        SailingRecord& out    // out: stored sailing record
+    );
+    /*
+    Indexed lookup of a sailing. Returns false if it does not exist.
+    */
+
+    //--------------------------------------
+    bool updateSailing(
+        const SailingRecord& record  // in: sailing to overwrite, matched by ID
+    );
+    /*
+    Overwrites the stored sailing with the same ID (lane lengths,
+    onboard count). Does not commit. Returns false if it does not exist.
     */
 
     //--------------------------------------
@@ -96,11 +181,23 @@ public:
     int getMatchingSailings(
         float height,                  // in: required vehicle height
         float length,                  // in: required vehicle length
-        SailingRecord* outArray,       // out: array of matching sailings
-        int maxCount                   // in: maximum results to return
+        const std::function<bool(const SailingRecord&)>& visit  // in: called per match; false stops
+    );
+    /*
+    Streams the sailings that can accommodate a vehicle with given size,
+    using SailingASM's lane-length indexes (no full scan, no result cap).
+    Order follows the index, not the file. The visitor must not modify
+    sailings. Returns the number of sailings visited.
+    */
+
+    //--------------------------------------
+    int getMatchingSailings(
+        float height,                      // in: required vehicle height
+        float length,                      // in: required vehicle length
+        std::vector<SailingRecord>& out    // out: every matching sailing, in file order
     );
     /*
-    Finds sailings that can accommodate a vehicle with given size.
+    Collects all matches of the streaming form above.
     Returns the number of matching sailings.
     */
 
@@ -156,15 +253,73 @@ public:
     - Freeing   (isReversing = true): RESTORE capacity to the lane specified by laneHint
       ('H' or 'L'). On success returns laneHint; on failure returns '\0'.
     This is used by ReservationManager to persist/restore laneUsed per reservation.
+    Does not commit the write-ahead log; the calling flow commits once
+    the whole booking/cancellation is written.
+    */
+
+    //--------------------------------------
+    char allocateLane(
+        const char* date,  // in: sailing ID
+        float height,      // in: vehicle height
+        float length       // in: vehicle length
+    );
+    /*
+    Silent form of the allocation above: tall vehicles (> 2.0 m) take
+    the high lane, others prefer the low lane. Returns 'H'/'L', or '\0'
+    if the sailing is missing, has no room or could not be written
+    (no lane is handed out without its capacity deducted). The sailing's record stays
+    locked until the operation commits, like every lane or onboard
+    update here, so concurrent bookings on it queue rather than race.
+    */
+
+    //--------------------------------------
+    bool lockSailing(
+        const char* date  // in: sailing ID
+    );
+    /*
+    Locks the sailing's record until the operation commits, before
+    anything is read from it (see recordFile.h for the lock order).
+    Returns false if the sailing does not exist.
+    */
+
+    //--------------------------------------
+    bool lockAllSailings();
+    /*
+    Locks the whole sailing file until the operation commits (bulk
+    import). Returns true if the lock is held.
+    */
+
+    //--------------------------------------
+    static char takeLane(
+        SailingRecord& record,  // in/out: sailing whose lane is reduced
+        float height,           // in: vehicle height
+        float length            // in: vehicle length
+    );
+    /*
+    The lane rule used by allocateLane, applied to a record in memory.
+    Returns 'H'/'L', or '\0' (record unchanged) if there is no room.
+    */
+
+    //--------------------------------------
+    bool releaseLane(
+        const char* date,  // in: sailing ID
+        float length,      // in: vehicle length to give back
+        char lane          // in: 'H' or 'L'
+    );
+    /*
+    Silent form of the freeing above. Returns false on a bad lane,
+    missing sailing or failed write (the last is reported on stderr).
     */
 
     //--------------------------------------
-    void updateOnboardCount(
+    bool updateOnboardCount(
         const char* date,  // in: sailing ID
         int delta          // in: +1 to increment, -1 to decrement
     );
     /*
-    Adjusts onboard vehicle count for a sailing.
+    Adjusts onboard vehicle count for a sailing. Returns false (and
+    reports it) if the sailing is missing or the record was not written.
+    Part of a larger operation; the caller commits the write-ahead log.
     */
 
     //--------------------------------------
@@ -172,31 +327,30 @@ public:
         const char* sailingID  // in: sailing ID
     );
     /*
-    Returns the number of onboard vehicles for a sailing.
+    Returns the number of onboard vehicles for a sailing
+    (read from the sailing record, no reservation scan).
     */
 
     //--------------------------------------
-    int getSailingsByPage(
-        const SailingRecord* matchList,  // in: filtered sailing list
-        int matchCount,                  // in: total number of matches
-        int pageNum,                     // in: which page to fetch (0-based)
-        int pageSize,                    // in: number per page
-        SailingRecord* outArray          // out: array of sailings on that page
+    RecordCursor<SailingRecord> matchingSailings(
+        float height,   // in: required vehicle height
+        float length,   // in: required vehicle length
+        int pageSize    // in: rows per page
     );
     /*
-    Extracts a page of sailings from the match list.
-    Returns the number of sailings placed in outArray.
+    Cursor over the sailings that can take the vehicle, in file order.
+    Only the matching slot numbers are kept; each page's records are
+    read from the sailing file when shown.
     */
 
     //--------------------------------------
-    const char* showAvailableAndSelect(
-        const SailingRecord* matchList,  // in: filtered sailing list
-        int matchCount,                  // in: number of available matches
-        int pageSize                     // in: page size to show
+    bool showAvailableAndSelect(
+        RecordCursor<SailingRecord>& matches,  // in/out: cursor from matchingSailings
+        char selectedId[DATE_LEN]              // out: chosen sailing ID
     );
     /*
     Displays paged list of available sailings and prompts user to select one.
-    Returns a const char* pointer to the selected sailing ID, or empty if none.
+    Returns true and fills selectedId, or false if the user quits.
     */
 };
 
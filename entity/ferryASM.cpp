@@ -12,51 +12,163 @@
 //***************************************************
 
 #include "ferryASM.h"
-#include "sailingASM.h"
-#include <fstream>
+#include "recordCursor.h"
+#include "../system/latencyStats.h"
+#include "../system/writeAheadLog.h"
 #include <iostream>
 #include <iomanip>
+#include <cstring>
 #define FILE_PATH "ferries.dat"
+#define FILE_KIND "FERY"
+#define ID_FILE_PATH "ferryIds.dat"
+#define ID_FILE_KIND "FIDS"
 #define PAGE_LENGTH 5
 
 // fstream FerryASM::file;
 // FerryASM ferryManager;
 
-std::fstream FerryASM::file;
+RecordFile<Ferry> FerryASM::file;
+RecordFile<FerryIdMark> FerryASM::idMark;
+std::vector<Ferry> FerryASM::catalog;
+std::unordered_map<std::string, int> FerryASM::nameIndex;
+std::unordered_map<int, int> FerryASM::idIndex;
+unsigned long FerryASM::seenAborts = 0;
+
+namespace {
+    // ferries.dat record before format v2 (no ferryId; the padding
+    // after the name held whatever was in memory)
+    struct FerryV1 {
+        char ferryName[26];
+        int HCLL;
+        int LCLL;
+    };
+}
+
+// Converts a v1 file (IDs numbered in file order), then opens it
+bool FerryASM::openFile() {
+    unsigned short nextId = 0;
+    migrateRecordFile<FerryV1, Ferry>(FILE_PATH, FILE_KIND, [&](const FerryV1& old, Ferry& ferry) {
+        memcpy(ferry.ferryName, old.ferryName, sizeof(ferry.ferryName));
+        ferry.ferryId = ++nextId;
+        ferry.HCLL = old.HCLL;
+        ferry.LCLL = old.LCLL;
+        return true;
+    });
+    if (!idMark.isOpen() && !idMark.open(ID_FILE_PATH, ID_FILE_KIND)) return false;
+    return file.open(FILE_PATH, FILE_KIND);
+}
 
-void FerryASM::initialize() {
-    file.open(FILE_PATH, ios::in | ios::out | ios::binary);
-    if (!file.is_open()) {
-        file.open(FILE_PATH, ios::out | ios::binary);
-        file.close();
-        file.open(FILE_PATH, ios::in | ios::out | ios::binary);
+bool FerryASM::initialize() {
+    bool opened = openFile();
+    if (!opened) {
+        cerr << "FerryASM Error: Could not open file." << endl;
     }
+    loadCatalog();
+    return opened;
 }
 
 void FerryASM::shutdown() {
-    if (file.is_open()) {
-        file.close();
+    file.close();
+    idMark.close();
+    catalog.clear();
+    nameIndex.clear();
+    idIndex.clear();
+}
+
+// A mapping of a replaced file would never see its changes
+bool FerryASM::reopenIfReplaced() {
+    if (!file.isOpen() || file.isCurrentFile()) return false;
+    file.close();
+    if (!openFile()) {
+        cerr << "FerryASM Error: Could not reopen file." << endl;
     }
+    loadCatalog();
+    return true;
 }
 
 void FerryASM::reset() {
-    if (file.is_open()) file.close();
+    if (!file.isOpen()) FerryASM::initialize();
 
-    ofstream resetFile(FILE_PATH, ios::out | ios::trunc | ios::binary);
-    
-    if (resetFile.is_open()) resetFile.close();
-    else {
+    if (!file.reset() || !idMark.reset()) {
         cerr << "Could not reset the Ferry file." << endl;
-        return;
     }
+    catalog.clear();
+    nameIndex.clear();
+    idIndex.clear();
+}
+
+// One pass over the mapping to fill the catalog and its indexes
+void FerryASM::loadCatalog() {
+    catalog.clear();
+    nameIndex.clear();
+    idIndex.clear();
+
+    ScanLock<Ferry> scan(file);
+    file.markSynced();
+    file.size();    // pick up the current length before walking
+    catalog.assign(file.begin(), file.end());
+    seenAborts = WriteAheadLog::aborts();
+    for (int i = 0; i < static_cast<int>(catalog.size()); ++i) {
+        indexFerry(i);
+    }
+}
+
+void FerryASM::indexFerry(int slot) {
+    nameIndex[nameKey(catalog[slot].ferryName)] = slot;
+    idIndex[catalog[slot].ferryId] = slot;
+}
+
+// IDs only grow: ferryIds.dat keeps the highest one issued, so deleting
+// the newest ferry does not free its ID (files from before the mark
+// start from the catalog). Only once 65535 is issued are gaps reused.
+int FerryASM::nextFerryId() {
+    int highest = issuedMark();
+    for (const Ferry& ferry : catalog) {
+        if (ferry.ferryId > highest) highest = ferry.ferryId;
+    }
+    if (highest < 65535) return highest + 1;
+
+    for (int id = 1; id <= 65535; ++id) {       // wrapped: first gap
+        if (!idIndex.count(id)) return id;
+    }
+    return 0;
+}
+
+int FerryASM::issuedMark() {
+    FerryIdMark mark;
+    if (idMark.size() == 0 || !idMark.get(0, mark)) return 0;
+    return static_cast<int>(mark.lastId);
+}
+
+// Written in the same group as the ferries it numbers
+bool FerryASM::raiseMark(int lastId) {
+    if (lastId <= issuedMark()) return true;
+    FerryIdMark mark = { static_cast<unsigned int>(lastId) };
+    if (idMark.size() == 0) return idMark.append(mark) >= 0;
+    return idMark.update(0, mark);
+}
 
-    FerryASM::initialize(); 
+// Another booth may have added or deleted a ferry, or an aborted
+// operation left a change here that never reached the file
+void FerryASM::syncCatalog() {
+    if (file.isOpen() && (file.changedElsewhere(true) || WriteAheadLog::aborts() != seenAborts))
+        loadCatalog();
+}
+
+bool FerryASM::lockAll() {
+    return file.lockTail(0);
+}
 
+// Ferry name as a key (the stored field may fill all 26 bytes)
+std::string FerryASM::nameKey(const char* ferryName) {
+    return std::string(ferryName, strnlen(ferryName, sizeof(Ferry::ferryName)));
 }
 
 
 bool FerryASM::writeFerry(const char* ferryName, const int HCLL, const int LCLL) {
-    if (!file.is_open()) {
+    static LatencyProbe latencyProbe("ferryASM.writeFerry");
+    LatencyTimer timer(latencyProbe);
+    if (!file.isOpen()) {
         cout << "File is not open for writing in FerryASM::writeFerry().\n" << endl;
         return false;
     }
@@ -67,128 +179,158 @@ bool FerryASM::writeFerry(const char* ferryName, const int HCLL, const int LCLL)
 
     newFerry.HCLL = HCLL;
     newFerry.LCLL = LCLL;
-    
-    file.clear();
-    file.seekp(0, ios::end); 
-    file.write(reinterpret_cast<const char*>(&newFerry), sizeof(newFerry));
-    file.flush();
-    // cout << "tellp(): " << file.tellp() << endl;
-    if (!file.good()) {
+
+    if (file.lockAppend() < 0) return false;
+    syncCatalog();
+    if (nameIndex.count(nameKey(newFerry.ferryName))) return false;
+    newFerry.ferryId = static_cast<unsigned short>(nextFerryId());
+    if (newFerry.ferryId == 0) {
+        cout << "No ferry IDs left in FerryASM::writeFerry()." << endl;
+        return false;
+    }
+
+    int index = file.append(newFerry);
+    if (index < 0 || !raiseMark(newFerry.ferryId)) {
         cout << "File write failed in FerryASM::writeFerry()." << endl;
         return false;
     }
+    if (index != static_cast<int>(catalog.size())) {
+        loadCatalog();      // file changed outside this catalog; start over
+    } else {
+        catalog.push_back(newFerry);
+        indexFerry(index);
+    }
     return true;
 }
 
-bool FerryASM::deleteFerry(char* ferryName) {
-    // check SailingASM for ferry being assigned
-    SailingASM sailingASM;
-    
-    vector<char*> matches = sailingASM.findSailingsWithFerry(ferryName);
-    
-    if(!matches.empty()) {
+bool FerryASM::writeFerries(const std::vector<Ferry>& ferries) {
+    static LatencyProbe latencyProbe("ferryASM.writeFerries");
+    LatencyTimer timer(latencyProbe);
+    if (ferries.empty()) return true;
+    if (!file.isOpen()) {
+        cout << "File is not open for writing in FerryASM::writeFerries().\n" << endl;
+        return false;
+    }
 
-        cout << "\n[WARNING] The ferry is in the following sailing(s):\n" << endl;
+    if (file.lockAppend() < 0) return false;
+    syncCatalog();
 
-        for (char* sailingID : matches) {
-            cout << sailingID << endl;
+    std::vector<Ferry> numbered(ferries);
+    int id = nextFerryId();
+    for (Ferry& ferry : numbered) {
+        if (id == 0 || id > 65535) {
+            cout << "No ferry IDs left in FerryASM::writeFerries()." << endl;
+            return false;
         }
-
-        cin.ignore(128, '\n');
-        cout << "\nThe ferry cannot be deleted while it is assigned to a sailing. Press enter to continue." << endl;
-        cin.get();
-
-        return false;
-
+        ferry.ferryId = static_cast<unsigned short>(id++);
     }
 
-    file.clear();
-    file.seekg(0, ios::beg);
-
-    std::fstream newFile("temp.dat", ios::out | ios::binary);
-    if (!newFile) {
-        std::cerr << "Failed to create temp file.\n";
+    int first = file.appendMany(numbered.data(), static_cast<int>(numbered.size()));
+    if (first < 0 || !raiseMark(numbered.back().ferryId)) {
+        cout << "File write failed in FerryASM::writeFerries()." << endl;
         return false;
     }
-
-    Ferry ferry;
-    bool found = false;
-
-    // copy over all records except the one to delete
-    while (file.read(reinterpret_cast<char*>(&ferry), sizeof(Ferry))) {
-        if (strncmp(ferry.ferryName, ferryName, sizeof(ferry.ferryName)) != 0) {
-            newFile.write(reinterpret_cast<char*>(&ferry), sizeof(Ferry));
-        } else {
-            found = true;
+    if (first != static_cast<int>(catalog.size())) {
+        loadCatalog();      // file changed outside this catalog; start over
+    } else {
+        for (const Ferry& ferry : numbered) {
+            catalog.push_back(ferry);
+            indexFerry(static_cast<int>(catalog.size()) - 1);
         }
     }
+    return true;
+}
 
-    file.close();
-    newFile.close();
+// Caller (ferryManager) checks that no sailing still uses the ferry
+bool FerryASM::deleteFerry(const char* ferryName) {
+    static LatencyProbe latencyProbe("ferryASM.deleteFerry");
+    LatencyTimer timer(latencyProbe);
+    // the catalog is small: lock all of it, then look
+    if (!file.lockTail(0)) return false;
+    syncCatalog();
 
-    if (!found) {
+    auto it = nameIndex.find(nameKey(ferryName));
+    if (it == nameIndex.end()) {
         // couldn't retrieve ferry to delete
         std::cerr << "Ferry not found: " << ferryName << "\n";
-        std::remove("temp.dat");
-        file.open(FILE_PATH, ios::in | ios::out | ios::binary); 
         return false;
     }
 
-    std::remove(FILE_PATH);              // Delete original
-    std::rename("temp.dat", FILE_PATH); 
+    int target = it->second;
+    int last = static_cast<int>(catalog.size()) - 1;
 
-    file.open(FILE_PATH, ios::in | ios::out | ios::binary);
+    // move the last ferry into the freed slot, then drop the tail;
+    // the catalog follows only once both are written
+    if ((target != last && !file.update(target, catalog[last])) || !file.truncate(last)) {
+        cout << "File write failed in FerryASM::deleteFerry()." << endl;
+        return false;
+    }
+
+    nameIndex.erase(it);
+    idIndex.erase(catalog[target].ferryId);
+    if (target != last) {
+        catalog[target] = catalog[last];
+        indexFerry(target);
+    }
+    catalog.pop_back();
 
     return true;
 }
 
 
 bool FerryASM::ferryExists(const char* ferryName) {
-    file.clear();
-    file.seekg(0, ios::beg);
+    syncCatalog();
+    return nameIndex.find(nameKey(ferryName)) != nameIndex.end();
+}
 
-    Ferry ferry;
-    while (file.read(reinterpret_cast<char*>(&ferry), sizeof(Ferry))) {
-        if (strncmp(ferry.ferryName, ferryName, sizeof(ferry.ferryName)) == 0) {
-            return true;
-        }
-    }
-    return false; // could not find ferry
+bool FerryASM::findFerry(const char* ferryName, Ferry& out) {
+    static LatencyProbe latencyProbe("ferryASM.findFerry");
+    LatencyTimer timer(latencyProbe);
+    syncCatalog();
+    auto it = nameIndex.find(nameKey(ferryName));
+    if (it == nameIndex.end()) return false;
+    out = catalog[it->second];
+    return true;
+}
+
+bool FerryASM::findFerryById(int ferryId, Ferry& out) {
+    syncCatalog();
+    auto it = idIndex.find(ferryId);
+    if (it == idIndex.end()) return false;
+    out = catalog[it->second];
+    return true;
 }
 
 bool FerryASM::showFerriesAndSelect(Ferry* selectedFerry, bool* quitMenu) {
     
-    ifstream inFile(FILE_PATH, ios::binary);
-    if (!inFile) {
+    if (!file.isOpen()) {
         std::cerr << "Failed to open ferry file.\n";
     }
+    syncCatalog();
 
-    // total ferry count
-    inFile.seekg(0, ios::end);
-    int totalFerries = inFile.tellg() / sizeof(Ferry);
-    if (totalFerries == 0) {
+    // pages are served from the resident catalog
+    RecordCursor<Ferry> cursor(
+        [] { return static_cast<int>(catalog.size()); },
+        [](int i, Ferry& out) { out = catalog[i]; return true; },
+        PAGE_LENGTH);
+
+    if (cursor.total() == 0) {
         cout << "\nNo ferries available to show.\n" << endl;
         return false;
     }
-    inFile.seekg(0, ios::beg);
 
-    int currentPage = 0;
-    char command;
+    string command;
 
     while (true) {
-        int start = currentPage * PAGE_LENGTH;
-        int end = min(start + PAGE_LENGTH, totalFerries);
-
-        inFile.seekg(start * sizeof(Ferry), ios::beg);
+        const vector<Ferry>& page = cursor.records();
 
         cout << "\n" << endl;
         cout << "===================== Available Ferries =====================\n" << endl;
         cout << setfill(' ');
-        for (int i = start; i < end; ++i) {
-            Ferry ferry;
-            inFile.read(reinterpret_cast<char*>(&ferry), sizeof(Ferry));
+        for (size_t i = 0; i < page.size(); ++i) {
+            const Ferry& ferry = page[i];
 
-            cout << right << setw(3) << (i - start + 1) << " ";
+            cout << right << setw(3) << (i + 1) << " ";
             cout << left << setw(28) << ferry.ferryName;
 
             cout << "HCLL: " << setw(4) << right << (int)ferry.HCLL << " m\t";
@@ -196,35 +338,31 @@ bool FerryASM::showFerriesAndSelect(Ferry* selectedFerry, bool* quitMenu) {
         }
 
 
-        cout << "\n[Results " << (start + 1) << " to " << end << " of " << totalFerries << "]" << endl;
-        cout << "\nSelect a ferry [1 ~ " << (end - start) << "], or type 'n' (next), 'p' (prev), or 'q' (quit): ";
-        cin >> command;
-
-        if (command == 'n') {
-            if ((currentPage + 1) * PAGE_LENGTH < totalFerries)
-                currentPage++;
-        } else if (command == 'p') {
-            if (currentPage > 0)
-                currentPage--;
-        } else if (command == 'q') {
+        cout << "\n[Results " << (cursor.first() + 1) << " to " << cursor.last() << " of " << cursor.total() << "]" << endl;
+        cout << "\nSelect a ferry [1 ~ " << page.size() << "], or type 'n' (next), 'p' (prev), or 'q' (quit): ";
+        if (!(cin >> command)) {
             *quitMenu = true;
-            return false; // maybe change this
-        } else if (isdigit(command)) {
-            int selection = command - '0';
-            if (selection >= 1 && selection <= (end - start)) {
-                // Go to selected record
-                int index = start + selection - 1;
-                inFile.seekg(index * sizeof(Ferry), ios::beg);
-                Ferry selected;
-                inFile.read(reinterpret_cast<char*>(&selected), sizeof(Ferry));
-                // strncpy(ferryName, selected.ferryName, size);
-                *selectedFerry = selected;
-                return true;
-            } else {
+            return false;
+        }
+
+        int selection = 0;
+        switch (parsePageCommand(command, selection)) {
+            case PageCommand::NEXT:
+                cursor.next();
+                break;
+            case PageCommand::PREV:
+                cursor.prev();
+                break;
+            case PageCommand::QUIT:
+                *quitMenu = true;
+                return false; // maybe change this
+            case PageCommand::SELECT:
+                if (cursor.pick(selection, *selectedFerry)) return true;
                 cout << "Invalid selection." << endl;
-            }
-        } else {
-            cout << "Invalid input.";
+                break;
+            default:
+                cout << "Invalid input.";
+                break;
         }
     }
 }
\ No newline at end of file
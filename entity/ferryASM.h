@@ -16,31 +16,61 @@
 #define FERRY_ASM_H
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "recordFile.h"
 using namespace std;
 
 //--------------------------------------
 // Ferry record structure
 struct Ferry {
-    char ferryName[26];  // Ferry name - 25 max chars + null
-    int HCLL;            // High Ceiling Lane Length
-    int LCLL;            // Low Ceiling Lane Length
+    char ferryName[26];         // Ferry name - 25 max chars + null
+    unsigned short ferryId;     // Catalog ID (1-65535) referenced by sailings; set by FerryASM
+    int HCLL;                   // High Ceiling Lane Length
+    int LCLL;                   // Low Ceiling Lane Length
+};
+
+//--------------------------------------
+// The one record of ferryIds.dat: the highest catalog ID handed out
+struct FerryIdMark {
+    unsigned int lastId;
 };
 
 class FerryASM {
 private:
-    static std::fstream file;
+    static RecordFile<Ferry> file;
+    static RecordFile<FerryIdMark> idMark;
+
+    // Resident copy of ferries.dat (same order as the file) and
+    // name -> slot and ID -> slot indexes over it; loaded by initialize().
+    static std::vector<Ferry> catalog;
+    static std::unordered_map<std::string, int> nameIndex;
+    static std::unordered_map<int, int> idIndex;
+    static unsigned long seenAborts;    // WriteAheadLog::aborts() at last load
+
+    static bool openFile();             // migrate a v1 file, then open
+    static void loadCatalog();
+    static void indexFerry(int slot);
+    static int nextFerryId();           // one past the highest ID ever issued, 0 if none left
+    static int issuedMark();            // the stored high-water mark, 0 if none yet
+    static bool raiseMark(int lastId);  // stage a higher mark with the new ferries
+    static void syncCatalog();          // reload if another handle changed the file
+    static std::string nameKey(const char* ferryName);
 
 public:
     //--------------------------------------
-    static void initialize();
+    static bool initialize();
     /*
-    Initializes the ferryASM system and opens the binary file.
+    Initializes the ferryASM system, maps the binary file and loads
+    the ferry catalog into memory. Returns false if the file could not
+    be opened.
     */
 
     //--------------------------------------
     static void shutdown();
     /*
-    Shuts down the system and flushes/closes the ferry file.
+    Shuts down the system and unmaps/closes the ferry file.
     */
 
     //--------------------------------------
@@ -49,6 +79,13 @@ public:
     Deletes all ferry records and resets the file.
     */
 
+    //--------------------------------------
+    static bool reopenIfReplaced();
+    /*
+    Reopens the ferry file and reloads the catalog if the path was
+    renamed over since it was opened. Returns true if it was reopened.
+    */
+
     //--------------------------------------
     static bool writeFerry(
         const char* ferryName,  // in: ferry name
@@ -56,16 +93,39 @@ public:
         const int LCLL          // in: low ceiling lane length
     );
     /*
-    Stores a new ferry record in the binary file.
-    Returns true on success.
+    Stores a new ferry record in the binary file with the next catalog
+    ID. IDs only grow, so a deleted ferry's ID is not issued again until
+    65535 has been. The name is checked again with the end of the file
+    locked. Returns true on success, false if the name exists or on
+    error.
+    */
+
+    //--------------------------------------
+    static bool writeFerries(
+        const std::vector<Ferry>& ferries  // in: new ferries (names not on file)
+    );
+    /*
+    Appends a batch of ferry records in one write (bulk import),
+    giving each the next catalog ID. Returns true on success.
+    */
+
+    //--------------------------------------
+    static bool lockAll();
+    /*
+    Locks the whole ferry file until the operation commits, so a bulk
+    import's duplicate checks hold until its write (see recordFile.h).
+    Returns true if the lock is held.
     */
 
     //--------------------------------------
     static bool deleteFerry(
-        char* ferryName  // in: ferry name to delete
+        const char* ferryName  // in: ferry name to delete
     );
     /*
-    Deletes a ferry record from the binary file by name.
+    Deletes a ferry record from the binary file by name. The last
+    record is moved into the freed slot and the file shrinks by one.
+    Returns false if the ferry is absent or either write fails.
+    Does not check sailings; see ReservationService::deleteFerry().
     */
 
     //--------------------------------------
@@ -73,7 +133,27 @@ public:
         const char* ferryName  // in: ferry name to check
     );
     /*
-    Returns true if ferry name exists in the file.
+    Returns true if ferry name exists (hash lookup; the file is only
+    re-read when another handle has changed it).
+    */
+
+    //--------------------------------------
+    static bool findFerry(
+        const char* ferryName,  // in: ferry name to look up
+        Ferry& out              // out: ferry record if found
+    );
+    /*
+    Copies the named ferry from the catalog. Returns false if absent.
+    */
+
+    //--------------------------------------
+    static bool findFerryById(
+        int ferryId,  // in: catalog ID stored in a sailing
+        Ferry& out    // out: ferry record if found
+    );
+    /*
+    Copies the ferry with the given ID from the catalog. Returns false
+    if absent.
     */
 
     //--------------------------------------
@@ -0,0 +1,197 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: pageCache.cpp
+// Purpose:
+//   Frame table, page index and CLOCK hand of the page cache. Frames
+//   are allocated on the first fill, so a process that never reads a
+//   record does not pay for the budget. One mutex guards it all (the
+//   server's worker threads share the cache).
+//***************************************************
+
+#include "pageCache.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    struct Frame {
+        unsigned long long key;     // owner << 32 | page
+        unsigned long long epoch;
+        size_t bytes;               // valid bytes of the page
+        bool used;
+        bool referenced;            // CLOCK second-chance bit
+    };
+
+    mutex guard;
+    size_t budgetBytes = PageCache::DEFAULT_BUDGET;
+    vector<Frame> frames;
+    vector<char> data;                              // frames.size() * PAGE_BYTES
+    unordered_map<unsigned long long, size_t> where;// key -> frame
+    size_t hand = 0;
+    unsigned lastOwner = 0;
+    PageCacheStats counters = PageCacheStats();
+
+    unsigned long long keyOf(unsigned owner, long long page) {
+        return (static_cast<unsigned long long>(owner) << 32) | static_cast<unsigned long long>(page & 0xFFFFFFFFLL);
+    }
+
+    char* pageData(size_t frame) {
+        return &data[frame * PageCache::PAGE_BYTES];
+    }
+
+    //--------------------------------------
+    // Frame to (re)use: the next one the hand finds unused or not
+    // referenced since it last passed (guard held)
+    size_t victim() {
+        for (;;) {
+            size_t i = hand;
+            hand = (hand + 1) % frames.size();
+            Frame& f = frames[i];
+            if (!f.used) return i;
+            if (f.referenced) {
+                f.referenced = false;
+                continue;
+            }
+            where.erase(f.key);
+            f.used = false;
+            --counters.pages;
+            ++counters.evictions;
+            return i;
+        }
+    }
+
+    //--------------------------------------
+    // Drops every page and frees the frames (guard held)
+    void clear() {
+        frames.clear();
+        data.clear();
+        data.shrink_to_fit();
+        where.clear();
+        hand = 0;
+        counters.pages = 0;
+    }
+}
+
+//--------------------------------------
+void PageCache::setBudget(size_t bytes) {
+    lock_guard<mutex> lock(guard);
+    budgetBytes = bytes - bytes % PAGE_BYTES;
+    clear();
+}
+
+//--------------------------------------
+size_t PageCache::budget() {
+    lock_guard<mutex> lock(guard);
+    return budgetBytes;
+}
+
+//--------------------------------------
+bool PageCache::enabled() {
+    lock_guard<mutex> lock(guard);
+    return budgetBytes > 0;
+}
+
+//--------------------------------------
+void PageCache::configureFromEnv() {
+    const char* env = getenv("SUPERFERRY_CACHE_KB");
+    if (env == nullptr) return;
+
+    char* end = nullptr;
+    long long kb = strtoll(env, &end, 10);
+    if (end == env || *end != '\0' || kb < 0) {
+        cerr << "[WARN] Invalid SUPERFERRY_CACHE_KB '" << env << "', keeping "
+             << budget() / 1024 << " KiB." << endl;
+        return;
+    }
+    setBudget(static_cast<size_t>(kb) * 1024);
+}
+
+//--------------------------------------
+unsigned PageCache::newOwner() {
+    lock_guard<mutex> lock(guard);
+    return ++lastOwner;
+}
+
+//--------------------------------------
+bool PageCache::read(unsigned owner, long long page, unsigned long long epoch,
+                     size_t offset, void* out, size_t len) {
+    lock_guard<mutex> lock(guard);
+    auto it = where.find(keyOf(owner, page));
+    if (it != where.end()) {
+        Frame& f = frames[it->second];
+        if (f.epoch == epoch && offset + len <= f.bytes) {
+            f.referenced = true;
+            memcpy(out, pageData(it->second) + offset, len);
+            ++counters.hits;
+            return true;
+        }
+    }
+    ++counters.misses;
+    return false;
+}
+
+//--------------------------------------
+void PageCache::fill(unsigned owner, long long page, unsigned long long epoch,
+                     const void* bytes, size_t len) {
+    lock_guard<mutex> lock(guard);
+    if (budgetBytes < PAGE_BYTES || len > PAGE_BYTES) return;
+    if (frames.empty()) {
+        counters.capacity = budgetBytes / PAGE_BYTES;
+        frames.assign(counters.capacity, Frame());
+        data.assign(counters.capacity * PAGE_BYTES, 0);
+    }
+
+    unsigned long long key = keyOf(owner, page);
+    size_t frame;
+    auto it = where.find(key);
+    if (it != where.end()) {
+        frame = it->second;     // a stale copy of the same page
+    } else {
+        frame = victim();
+        where[key] = frame;
+        ++counters.pages;
+    }
+
+    Frame& f = frames[frame];
+    f.key = key;
+    f.epoch = epoch;
+    f.bytes = len;
+    f.used = true;
+    f.referenced = false;
+    memcpy(pageData(frame), bytes, len);
+}
+
+//--------------------------------------
+// A write past the valid bytes (an append onto the last page) extends
+// them; one that would leave a gap is not cached.
+void PageCache::write(unsigned owner, long long page, unsigned long long epoch,
+                      size_t offset, const void* bytes, size_t len) {
+    lock_guard<mutex> lock(guard);
+    auto it = where.find(keyOf(owner, page));
+    if (it == where.end()) return;
+    Frame& f = frames[it->second];
+    if (f.epoch != epoch || offset > f.bytes || offset + len > PAGE_BYTES) return;
+
+    memcpy(pageData(it->second) + offset, bytes, len);
+    if (offset + len > f.bytes) f.bytes = offset + len;
+    ++counters.writes;
+}
+
+//--------------------------------------
+PageCacheStats PageCache::stats() {
+    lock_guard<mutex> lock(guard);
+    PageCacheStats now = counters;
+    now.capacity = budgetBytes / PAGE_BYTES;
+    return now;
+}
+
+//--------------------------------------
+void PageCache::resetStats() {
+    lock_guard<mutex> lock(guard);
+    counters.hits = counters.misses = counters.evictions = counters.writes = 0;
+}
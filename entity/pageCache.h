@@ -0,0 +1,82 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: pageCache.h
+// Purpose:
+//   Process-wide cache of record pages in front of RecordFile<T>::get().
+//   A page is the run of whole records that fits in PAGE_BYTES (a
+//   record never straddles two pages). A read that misses copies the
+//   whole page out of the mapping under one shared lock; later reads
+//   of any record on it are served from memory without taking the
+//   fcntl lock pair a mapped read needs.
+//
+//   Pages are tagged with the owning handle and an epoch. The handle
+//   moves to a new epoch whenever another handle changed the file (its
+//   .gen counters moved), so stale pages are never returned. Changes
+//   made through the owning handle are written through into the
+//   cached page as well as the mapping.
+//
+//   The memory budget is fixed (SUPERFERRY_CACHE_KB, 0 turns the cache
+//   off); a full cache evicts with the CLOCK (second chance) policy.
+//   Hit, miss and eviction counts are kept for tuning the budget.
+//***************************************************
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <cstddef>
+
+//--------------------------------------
+// Counters since start (or resetStats())
+struct PageCacheStats {
+    unsigned long long hits;        // reads served from a cached page
+    unsigned long long misses;      // reads that had to go to the mapping
+    unsigned long long evictions;   // pages dropped to make room
+    unsigned long long writes;      // write-throughs into a cached page
+    size_t pages;                   // pages cached now
+    size_t capacity;                // pages the budget allows
+};
+
+class PageCache {
+public:
+    static const size_t PAGE_BYTES = 4096;
+    static const size_t DEFAULT_BUDGET = 4 * 1024 * 1024;
+
+    //--------------------------------------
+    // Memory budget in bytes (rounded down to whole pages; 0 disables
+    // the cache). Changing it empties the cache.
+    static void setBudget(size_t bytes);
+    static size_t budget();
+    static bool enabled();
+
+    //--------------------------------------
+    // Reads SUPERFERRY_CACHE_KB (budget in KiB, 0 = off).
+    static void configureFromEnv();
+
+    //--------------------------------------
+    // A fresh owner tag for a newly opened file handle
+    static unsigned newOwner();
+
+    //--------------------------------------
+    // Copies len bytes at offset of the owner's page into out if that
+    // page is cached at the given epoch. Counts a hit or a miss.
+    static bool read(unsigned owner, long long page, unsigned long long epoch,
+                     size_t offset, void* out, size_t len);
+
+    //--------------------------------------
+    // Caches len bytes (at most PAGE_BYTES) as the owner's page,
+    // evicting another page if the cache is full.
+    static void fill(unsigned owner, long long page, unsigned long long epoch,
+                     const void* data, size_t len);
+
+    //--------------------------------------
+    // Write-through: if the owner's page is cached at epoch, overwrites
+    // len bytes of it at offset; otherwise does nothing.
+    static void write(unsigned owner, long long page, unsigned long long epoch,
+                      size_t offset, const void* data, size_t len);
+
+    //--------------------------------------
+    static PageCacheStats stats();
+    static void resetStats();
+};
+
+#endif // PAGE_CACHE_H
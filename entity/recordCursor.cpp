@@ -0,0 +1,25 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: recordCursor.cpp
+// Purpose: Picker input parsing shared by the paged record lists
+// (the cursor itself is a template in recordCursor.h).
+//***************************************************
+
+#include "recordCursor.h"
+#include <cctype>
+#include <cstdlib>
+
+//--------------------------------------
+PageCommand parsePageCommand(const std::string& input, int& selection) {
+    selection = 0;
+    if (input == "n" || input == "N") return PageCommand::NEXT;
+    if (input == "p" || input == "P") return PageCommand::PREV;
+    if (input == "q" || input == "Q") return PageCommand::QUIT;
+
+    if (input.empty() || input.length() > 6) return PageCommand::INVALID;
+    for (char c : input) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return PageCommand::INVALID;
+    }
+    selection = std::atoi(input.c_str());
+    return selection >= 1 ? PageCommand::SELECT : PageCommand::INVALID;
+}
@@ -0,0 +1,131 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: recordCursor.h
+// Purpose:
+//   Page-at-a-time cursor over a record store, used by the paged
+//   pickers (ferries, sailings, matching sailings). The cursor knows
+//   the store only through two callbacks: one returns the current
+//   record count and one fetches the record at a position. It holds
+//   the visible page and nothing else, fetching it lazily when the
+//   page changes.
+//
+//   parsePageCommand() turns a picker's input line into next / prev /
+//   quit / a selection number of any width.
+//***************************************************
+
+#ifndef RECORD_CURSOR_H
+#define RECORD_CURSOR_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+//--------------------------------------
+// Input understood by the paged pickers
+enum class PageCommand { NEXT, PREV, QUIT, SELECT, INVALID };
+
+//--------------------------------------
+// Parses "n"/"p"/"q" (either case) or a positive number.
+// Returns SELECT with the number in selection for the latter.
+PageCommand parsePageCommand(
+    const std::string& input,   // in: token or line typed by the user
+    int& selection              // out: 1-based choice when SELECT
+);
+
+//--------------------------------------
+// Class: RecordCursor<T>
+template <typename T>
+class RecordCursor {
+public:
+    typedef std::function<int()> CountFn;           // current number of records
+    typedef std::function<bool(int, T&)> FetchFn;   // record at a position
+
+private:
+    CountFn countFn;
+    FetchFn fetchFn;
+    int pageSize;
+    int pageNum;
+    int totalCount;
+    std::vector<T> window;      // records of the current page
+    bool loaded;                // window matches pageNum
+
+    void load() {
+        if (loaded) return;
+        window.clear();
+        for (int i = first(); i < last(); ++i) {
+            T record;
+            if (fetchFn(i, record)) window.push_back(record);
+        }
+        loaded = true;
+    }
+
+public:
+    RecordCursor(CountFn count, FetchFn fetch, int size)
+        : countFn(count), fetchFn(fetch), pageSize(size > 0 ? size : 1),
+          pageNum(0), totalCount(0), loaded(false) {
+        refresh();
+    }
+
+    //--------------------------------------
+    // Re-reads the record count (after a delete, say), keeps the page
+    // in range and drops the cached page.
+    void refresh() {
+        totalCount = countFn();
+        if (totalCount < 0) totalCount = 0;
+        if (pageNum >= pages()) pageNum = pages() - 1;
+        if (pageNum < 0) pageNum = 0;
+        loaded = false;
+    }
+
+    //--------------------------------------
+    int total() const { return totalCount; }
+    int page() const { return pageNum; }                                   // 0-based
+    int pages() const { return (totalCount + pageSize - 1) / pageSize; }
+    int first() const { return pageNum * pageSize; }                       // position of first row shown
+    int last() const {                                                     // one past the last row shown
+        int end = first() + pageSize;
+        return end < totalCount ? end : totalCount;
+    }
+
+    //--------------------------------------
+    // The visible page, fetched on first use after a move
+    const std::vector<T>& records() {
+        load();
+        return window;
+    }
+
+    //--------------------------------------
+    // Page moves. Return false (and stay put) at either end.
+    bool next() {
+        if (pageNum + 1 >= pages()) return false;
+        pageNum++;
+        loaded = false;
+        return true;
+    }
+
+    bool prev() {
+        if (pageNum == 0) return false;
+        pageNum--;
+        loaded = false;
+        return true;
+    }
+
+    bool seek(int newPage) {
+        if (newPage < 0 || newPage >= pages()) return false;
+        if (newPage != pageNum) loaded = false;
+        pageNum = newPage;
+        return true;
+    }
+
+    //--------------------------------------
+    // Copies the choice-th row of the visible page (1-based).
+    // Returns false if the choice is not on the page.
+    bool pick(int choice, T& out) {
+        load();
+        if (choice < 1 || choice > static_cast<int>(window.size())) return false;
+        out = window[choice - 1];
+        return true;
+    }
+};
+
+#endif // RECORD_CURSOR_H
@@ -0,0 +1,347 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: recordFile.cpp
+// Purpose:
+//   MappedFile implementation: open/create, mmap, grow-on-append,
+//   shrink-on-truncate, msync, fcntl range locks, the shared change
+//   counters and the file header / migration support for the
+//   RecordFile<T> template.
+//***************************************************
+
+#include "recordFile.h"
+#include "../system/ioTrace.h"
+#include <iostream>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    // Locks owned by the open file description where available (Linux),
+    // so two handles on one file in the same process exclude each other
+    // and closing one handle does not drop the other's locks.
+#if defined(F_OFD_SETLKW)
+    const int LOCK_WAIT = F_OFD_SETLKW;
+    const int LOCK_TRY  = F_OFD_SETLK;
+#else
+    const int LOCK_WAIT = F_SETLKW;
+    const int LOCK_TRY  = F_SETLK;
+#endif
+
+    const size_t COUNTER_BYTES = 64;    // size of a <file>.gen counter file
+    const char MAGIC[4] = { 'S', 'F', 'R', 'Y' };
+
+    //--------------------------------------
+    bool writeFully(int fd, const char* data, long long bytes) {
+        while (bytes > 0) {
+            ssize_t n = ::write(fd, data, static_cast<size_t>(bytes));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            bytes -= n;
+        }
+        return true;
+    }
+}
+
+//--------------------------------------
+FileHeader makeHeader(const char* kind, unsigned int recordSize) {
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    memcpy(header.kind, kind, sizeof(header.kind));
+    header.version = RECORD_FORMAT_VERSION;
+    header.recordSize = recordSize;
+    return header;
+}
+
+//--------------------------------------
+MappedFile::MappedFile()
+    : fd(-1), base(nullptr), mappedBytes(0), fileBytes(0), counters(localCounters) {
+    localCounters[0] = localCounters[1] = 0;
+}
+
+//--------------------------------------
+MappedFile::~MappedFile() {
+    close();
+}
+
+//--------------------------------------
+// Open or create the file, then map its current contents
+bool MappedFile::open(const char* path) {
+    close();
+
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        cerr << "[ERROR] Could not open " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    filePath = path;
+    IoTrace::note(IoOp::OPEN, filePath);
+    fileBytes = 0;
+    openCounters();
+    return refresh();
+}
+
+//--------------------------------------
+void MappedFile::close() {
+    unmap();
+    closeCounters();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    fileBytes = 0;
+}
+
+//--------------------------------------
+void MappedFile::unmap() {
+    if (base != nullptr) {
+        munmap(base, static_cast<size_t>(mappedBytes));
+        base = nullptr;
+    }
+    mappedBytes = 0;
+}
+
+//--------------------------------------
+// Map at least `bytes`, rounding capacity up to a power of two
+// (minimum 64 KiB) so a run of appends remaps O(log n) times.
+bool MappedFile::mapAtLeast(long long bytes) {
+    if (bytes <= mappedBytes) return true;
+
+    long long capacity = 64 * 1024;
+    while (capacity < bytes) capacity *= 2;
+
+    unmap();
+    IoTrace::note(IoOp::MAP, filePath, capacity);
+    void* p = mmap(nullptr, static_cast<size_t>(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        cerr << "[ERROR] mmap failed for " << filePath << ": " << strerror(errno) << endl;
+        return false;
+    }
+    base = static_cast<char*>(p);
+    mappedBytes = capacity;
+    return true;
+}
+
+//--------------------------------------
+bool MappedFile::refresh() {
+    if (fd < 0) return false;
+
+    struct stat st;
+    IoTrace::note(IoOp::STAT, filePath);
+    if (fstat(fd, &st) != 0) return false;
+
+    fileBytes = static_cast<long long>(st.st_size);
+    return mapAtLeast(fileBytes);
+}
+
+//--------------------------------------
+bool MappedFile::resize(long long bytes) {
+    if (fd < 0) return false;
+    if (bytes < 0) bytes = 0;
+
+    IoTrace::note(IoOp::RESIZE, filePath, bytes);
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        cerr << "[ERROR] Could not resize " << filePath << ": " << strerror(errno) << endl;
+        return false;
+    }
+    fileBytes = bytes;
+    return mapAtLeast(bytes);
+}
+
+//--------------------------------------
+bool MappedFile::flush() {
+    if (base == nullptr || fileBytes == 0) return true;
+    IoTrace::note(IoOp::SYNC, filePath, fileBytes);
+    return msync(base, static_cast<size_t>(fileBytes), MS_ASYNC) == 0;
+}
+
+//--------------------------------------
+bool MappedFile::sync() {
+    if (base == nullptr || fileBytes == 0) return true;
+    IoTrace::note(IoOp::SYNC, filePath, fileBytes);
+    return msync(base, static_cast<size_t>(fileBytes), MS_SYNC) == 0;
+}
+
+//--------------------------------------
+// Map <file>.gen, creating it zero-filled on first use. Without it the
+// counters are process-local and changes by other processes go unseen.
+void MappedFile::openCounters() {
+    closeCounters();
+
+    string genPath = filePath + ".gen";
+    int gfd = ::open(genPath.c_str(), O_RDWR | O_CREAT, 0644);
+    IoTrace::note(IoOp::OPEN, genPath);
+    if (gfd >= 0) {
+        struct stat st;
+        IoTrace::note(IoOp::STAT, genPath);
+        if (fstat(gfd, &st) == 0 &&
+            (st.st_size >= static_cast<off_t>(COUNTER_BYTES) || ftruncate(gfd, COUNTER_BYTES) == 0)) {
+            IoTrace::note(IoOp::MAP, genPath, COUNTER_BYTES);
+            void* p = mmap(nullptr, COUNTER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, gfd, 0);
+            if (p != MAP_FAILED) counters = static_cast<unsigned long long*>(p);
+        }
+        ::close(gfd);
+    }
+    if (counters == localCounters) {
+        cerr << "[WARN] Could not map " << genPath << "; changes by other processes will not be detected." << endl;
+    }
+}
+
+//--------------------------------------
+void MappedFile::closeCounters() {
+    if (counters != localCounters) {
+        munmap(counters, COUNTER_BYTES);
+        counters = localCounters;
+    }
+}
+
+//--------------------------------------
+unsigned long long MappedFile::changes(Change kind) const {
+    return __atomic_load_n(&counters[static_cast<int>(kind)], __ATOMIC_ACQUIRE);
+}
+
+//--------------------------------------
+unsigned long long MappedFile::noteChange(Change kind) {
+    return __atomic_add_fetch(&counters[static_cast<int>(kind)], 1, __ATOMIC_ACQ_REL);
+}
+
+//--------------------------------------
+// A file that is exactly one zeroed header long was cut short while
+// being created and counts as empty.
+HeaderState MappedFile::headerState(const FileHeader& expected) const {
+    if (fileBytes == 0) return HeaderState::EMPTY;
+    if (fileBytes < HEADER_BYTES) return HeaderState::LEGACY;
+
+    FileHeader found;
+    memcpy(&found, base, sizeof(found));
+    if (memcmp(found.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        static const FileHeader zero = FileHeader();
+        bool blank = fileBytes == HEADER_BYTES && memcmp(&found, &zero, sizeof(found)) == 0;
+        return blank ? HeaderState::EMPTY : HeaderState::LEGACY;
+    }
+    return memcmp(&found, &expected, sizeof(found)) == 0 ? HeaderState::CURRENT : HeaderState::MISMATCH;
+}
+
+//--------------------------------------
+HeaderState MappedFile::prepareHeader(const FileHeader& expected) {
+    if (!lock(0, HEADER_BYTES, LockMode::EXCLUSIVE)) return HeaderState::MISMATCH;
+
+    HeaderState state = refresh() ? headerState(expected) : HeaderState::MISMATCH;
+    if (state == HeaderState::EMPTY) {
+        if (resize(HEADER_BYTES)) {
+            memcpy(base, &expected, sizeof(expected));
+            sync();
+            state = HeaderState::CURRENT;
+        } else {
+            state = HeaderState::MISMATCH;
+        }
+    }
+
+    lock(0, HEADER_BYTES, LockMode::NONE);
+    return state;
+}
+
+//--------------------------------------
+bool MappedFile::isCurrentFile() const {
+    if (fd < 0) return false;
+
+    struct stat mine, named;
+    IoTrace::note(IoOp::STAT, filePath);
+    if (fstat(fd, &mine) != 0) return false;
+    IoTrace::note(IoOp::STAT, filePath);
+    if (::stat(filePath.c_str(), &named) != 0) return false;
+    return mine.st_dev == named.st_dev && mine.st_ino == named.st_ino;
+}
+
+//--------------------------------------
+// The new file is complete and synced before it is renamed over the
+// old one, so other openers see either format, never half of one.
+bool MappedFile::replaceWith(const FileHeader& header, const void* records,
+                             long long bytes, const string& backupPath) {
+    if (fd < 0) return false;
+
+    string tempPath = filePath + ".migrating";
+    int out = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = out >= 0 &&
+              writeFully(out, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+              writeFully(out, static_cast<const char*>(records), bytes) &&
+              fsync(out) == 0;
+    if (out >= 0) ::close(out);
+
+    if (ok) {
+        ::unlink(backupPath.c_str());
+        ok = ::link(filePath.c_str(), backupPath.c_str()) == 0 &&
+             ::rename(tempPath.c_str(), filePath.c_str()) == 0;
+    }
+    if (!ok) {
+        cerr << "[ERROR] Could not migrate " << filePath << ": " << strerror(errno) << endl;
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    noteChange(Change::LAYOUT);
+    return true;
+}
+
+//--------------------------------------
+bool MappedFile::lock(long long offset, long long len, LockMode mode) {
+    if (fd < 0) return false;
+
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type   = (mode == LockMode::EXCLUSIVE) ? F_WRLCK : (mode == LockMode::SHARED) ? F_RDLCK : F_UNLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start  = static_cast<off_t>(offset);
+    fl.l_len    = static_cast<off_t>(len);
+
+    IoTrace::note(IoOp::LOCK, filePath);
+    while (fcntl(fd, LOCK_WAIT, &fl) != 0) {
+        if (errno == EINTR) continue;
+        cerr << "[ERROR] Could not lock " << filePath << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------
+bool MappedFile::tryLock(long long offset, long long len, LockMode mode) {
+    if (fd < 0) return false;
+
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type   = (mode == LockMode::EXCLUSIVE) ? F_WRLCK : (mode == LockMode::SHARED) ? F_RDLCK : F_UNLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start  = static_cast<off_t>(offset);
+    fl.l_len    = static_cast<off_t>(len);
+
+    IoTrace::note(IoOp::LOCK, filePath);
+    if (fcntl(fd, LOCK_TRY, &fl) == 0) return true;
+    if (errno == EACCES) errno = EAGAIN;        // F_SETLK may report a conflict either way
+    if (errno != EAGAIN) {
+        cerr << "[ERROR] Could not lock " << filePath << ": " << strerror(errno) << endl;
+    }
+    return false;
+}
+
+//--------------------------------------
+bool MappedFile::readAt(long long offset, void* out, long long bytes) {
+    if (fd < 0) return false;
+    IoTrace::note(IoOp::SYS_READ, filePath, bytes);
+    char* to = static_cast<char*>(out);
+    while (bytes > 0) {
+        ssize_t n = ::pread(fd, to, static_cast<size_t>(bytes), static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            cerr << "[ERROR] Could not read " << filePath << ": "
+                 << (n < 0 ? strerror(errno) : "unexpected end of file") << endl;
+            return false;
+        }
+        to += n;
+        offset += n;
+        bytes -= n;
+    }
+    return true;
+}
@@ -0,0 +1,955 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: recordFile.h
+// Purpose:
+//   Memory-mapped storage for fixed-length binary record files.
+//   MappedFile owns the descriptor and the shared mapping; the
+//   RecordFile<T> template exposes the mapping as a typed array so
+//   the ASM classes scan records with a pointer walk instead of a
+//   seekg/read pair per record.
+//
+//   Every file starts with a FileHeader (magic, record kind, format
+//   version, record size) followed by exactly count * sizeof(T) bytes,
+//   so other handles see the same record count. The mapping itself is
+//   sized to a larger power-of-two capacity and is only rebuilt when
+//   an append outgrows it. Files from before the header (format v1)
+//   are converted once by migrateRecordFile().
+//
+//   Every mutation is also recorded in the write-ahead log; callers
+//   mark the end of a logical operation with WriteAheadLog::commit().
+//   While the log is open, mutations are staged in memory (inside a
+//   Transaction or not) and only reach the mapping once the log holds
+//   the whole group, so a crash never leaves half an operation behind.
+//
+//   Several processes may share the data files. Access is arbitrated
+//   with fcntl byte-range locks on the data file itself:
+//     - get() holds a shared lock on the one record while copying it;
+//     - update() takes an exclusive lock on the one record;
+//     - append, truncate and compaction lock the tail of the file, from
+//       the first record they move or drop to beyond the end (a whole
+//       file compaction is the tail from record 0);
+//     - pointer walks (begin()..end()) run under a ScanLock.
+//   Exclusive locks are kept until the operation ends (commit() or
+//   abort() in the log), so staged writes are applied under them.
+//   Operations lock files in the order ferries, vehicles, sailings,
+//   reservations, and within a file in ascending offset order.
+//
+//   A shared counter pair in <file>.gen counts layout changes (the
+//   record count or record positions) and content changes, so an
+//   in-memory index can tell when another handle changed the file.
+//
+//   get() reads through the process-wide PageCache (pageCache.h): a
+//   cached page is used while the counters show no change by another
+//   handle, and this handle's own writes go into it as well.
+//
+//   In-memory mode (writeBehind.h) keeps the records in a table read
+//   with one pread at open(): get(), walks and key scans use the table,
+//   mutations change it and are logged as usual, and the data file is
+//   written back by the background writer and at close(). The handle
+//   then holds an exclusive lock on the whole file instead of record
+//   locks, and bypasses the page cache.
+//***************************************************
+
+#ifndef RECORD_FILE_H
+#define RECORD_FILE_H
+
+#include <string>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <mutex>
+#include "../system/writeAheadLog.h"
+#include "../system/writeBehind.h"
+#include "../system/ioTrace.h"
+#include "../system/keyScan.h"
+#include "pageCache.h"
+
+//--------------------------------------
+// fcntl lock request for a byte range (NONE releases it)
+enum class LockMode { NONE, SHARED, EXCLUSIVE };
+
+//--------------------------------------
+// Kinds of change counted in a file's shared change counters
+enum class Change { LAYOUT, CONTENT };
+
+//--------------------------------------
+// First bytes of every record file (format v2 onwards)
+struct FileHeader {
+    char magic[4];              // "SFRY"
+    char kind[4];               // record type, e.g. "SAIL"
+    unsigned int version;       // RECORD_FORMAT_VERSION when written
+    unsigned int recordSize;    // sizeof the record struct
+};
+
+const unsigned int RECORD_FORMAT_VERSION = 2;
+const long long HEADER_BYTES = sizeof(FileHeader);
+
+//--------------------------------------
+// Header for the current format
+FileHeader makeHeader(const char* kind, unsigned int recordSize);
+
+//--------------------------------------
+// What the front of a file holds, compared with an expected header
+enum class HeaderState {
+    EMPTY,      // no records and no header yet
+    CURRENT,    // the expected header
+    LEGACY,     // no header: a v1 file of bare records
+    MISMATCH    // a header of another kind, version or record size
+};
+
+//--------------------------------------
+// Class: MappedFile
+// Byte-level file + MAP_SHARED mapping (implementation in recordFile.cpp)
+class MappedFile {
+private:
+    int fd;                     // open descriptor, -1 when closed
+    char* base;                 // start of mapping, nullptr when nothing mapped
+    long long mappedBytes;      // size of the mapping (>= fileBytes)
+    long long fileBytes;        // current file size as last seen
+    std::string filePath;
+    unsigned long long* counters;       // shared change counters (<file>.gen), one per Change
+    unsigned long long localCounters[2];// stand-in when the counter file cannot be mapped
+
+    bool mapAtLeast(long long bytes);   // (re)map so that `bytes` are addressable
+    void unmap();
+    void openCounters();
+    void closeCounters();
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //--------------------------------------
+    // Opens (creating if missing) and maps the file.
+    // Returns true on success.
+    bool open(const char* path);
+
+    //--------------------------------------
+    // Unmaps and closes. Safe to call twice.
+    void close();
+
+    //--------------------------------------
+    bool isOpen() const { return fd >= 0; }
+    long long size() const { return fileBytes; }    // cached size in bytes
+    char* bytes() const { return base; }            // invalidated by resize()/refresh()
+    const std::string& path() const { return filePath; }
+
+    //--------------------------------------
+    // Re-reads the file size (another handle may have grown or shrunk
+    // the file) and extends the mapping if needed.
+    bool refresh();
+
+    //--------------------------------------
+    // Sets the file size with ftruncate and grows the mapping as needed.
+    bool resize(long long bytes);
+
+    //--------------------------------------
+    // Schedules write-back of dirty pages (msync MS_ASYNC).
+    bool flush();
+
+    //--------------------------------------
+    // Blocks until dirty pages are on disk (msync MS_SYNC).
+    bool sync();
+
+    //--------------------------------------
+    // Sets, changes or releases an fcntl lock on [offset, offset + len),
+    // waiting for conflicting locks held by other handles; len 0 runs to
+    // the end of the file and beyond. Where the system has them, the
+    // locks are open-file-description locks, owned by this handle rather
+    // than the whole process.
+    bool lock(long long offset, long long len, LockMode mode);
+
+    //--------------------------------------
+    // As lock(), but never waits: returns false with errno EAGAIN (and
+    // no message) when another handle holds a conflicting lock.
+    bool tryLock(long long offset, long long len, LockMode mode);
+
+    //--------------------------------------
+    // Reads bytes at offset straight from the file with pread (one
+    // sequential read, whatever the mapping holds). Returns false on a
+    // short read.
+    bool readAt(long long offset, void* out, long long bytes);
+
+    //--------------------------------------
+    // Shared change counters: the current value, and an increment that
+    // returns the new value.
+    unsigned long long changes(Change kind) const;
+    unsigned long long noteChange(Change kind);
+
+    //--------------------------------------
+    // Header checks. headerState() looks at the mapping as last
+    // refreshed; prepareHeader() locks the header, writes it into an
+    // empty file and returns the state found (EMPTY becomes CURRENT).
+    HeaderState headerState(const FileHeader& expected) const;
+    HeaderState prepareHeader(const FileHeader& expected);
+
+    //--------------------------------------
+    // True while the descriptor is still the file at path() (a
+    // migration renames a new file over it).
+    bool isCurrentFile() const;
+
+    //--------------------------------------
+    // Migration: writes header + records to a new file, keeps the
+    // present file as backupPath and renames the new one into place.
+    // Bumps the layout counter. The handle keeps the old file.
+    bool replaceWith(const FileHeader& header, const void* records,
+                     long long bytes, const std::string& backupPath);
+};
+
+//--------------------------------------
+// Class: RecordFile<T>
+// Typed view over a MappedFile holding an array of T.
+// T must be trivially copyable (plain struct of chars/ints/floats).
+template <typename T>
+class RecordFile : public StagedWriter, public WriteBehindTable {
+private:
+    MappedFile mf;
+    char kind[4];               // header kind given to open()
+
+    // transaction overlay (see stage())
+    bool staging;
+    int stagedCount;            // logical record count inside the transaction
+    int stagedLowWater;         // smallest count truncated to; records past it read as zero
+    bool stagedResize;          // an append/truncate is staged (the tail is locked)
+    std::map<int, T> stagedRecords;
+
+    // exclusive byte ranges held until the operation ends (see acquire())
+    typedef std::pair<long long, long long> Range;
+    static const long long TAIL = LLONG_MAX;        // range end: to the end of the file and beyond
+    std::vector<Range> held;
+
+    // change counters as last caught up with: by the cached size, and
+    // by the owner's in-memory index (see changedElsewhere())
+    unsigned long long sizeSeen;
+    unsigned long long layoutSeen;
+    unsigned long long contentSeen;
+
+    // page cache state: our owner tag, the epoch our pages are valid
+    // for, and the counters that epoch reflects (see cacheEpochNow())
+    static const int PAGE_RECORDS = static_cast<int>(PageCache::PAGE_BYTES / sizeof(T));
+    static_assert(PAGE_RECORDS > 0, "record larger than a cache page");
+    unsigned cacheOwner;
+    unsigned long long cacheEpoch;
+    unsigned long long cacheLayout;
+    unsigned long long cacheContent;
+
+    // in-memory mode: the records, the ones changed since the last
+    // write-back (list + per-record mark), and whether the file size
+    // must follow. The guard is taken by mutations and by writeBack(),
+    // which may run on the writer thread; reads need none.
+    bool resident;
+    std::vector<T> table;
+    std::vector<int> dirty;
+    std::vector<bool> dirtyMark;
+    bool tableResized;
+    std::mutex tableGuard;
+
+    int cachedCount() const {
+        if (resident) return static_cast<int>(table.size());
+        if (mf.size() <= HEADER_BYTES) return 0;
+        return static_cast<int>((mf.size() - HEADER_BYTES) / static_cast<long long>(sizeof(T)));
+    }
+
+    static long long offsetOf(int index) {
+        return HEADER_BYTES + static_cast<long long>(index) * static_cast<long long>(sizeof(T));
+    }
+
+    //--------------------------------------
+    // True when the current mutation is staged until the log commits
+    // (see WriteAheadLog::stageMutation()). The first staged mutation
+    // enlists this file with the log.
+    bool stage() {
+        if (!WriteAheadLog::stageMutation()) return false;
+        if (!staging) {
+            if (!resident) mf.refresh();
+            staging = true;
+            stagedResize = false;
+            stagedCount = cachedCount();
+            stagedLowWater = stagedCount;
+            WriteAheadLog::enlist(this);
+        }
+        return true;
+    }
+
+    //--------------------------------------
+    // True if [start, end) lies inside a range this handle holds.
+    bool holds(long long start, long long end) const {
+        for (const Range& r : held) {
+            if (r.first <= start && end <= r.second) return true;
+        }
+        return false;
+    }
+
+    //--------------------------------------
+    // Exclusive lock on [start, end), kept until releaseLocks().
+    bool acquire(long long start, long long end) {
+        if (resident || holds(start, end)) return true;
+        if (!mf.lock(start, end == TAIL ? 0 : end - start, LockMode::EXCLUSIVE)) return false;
+        if (held.empty()) WriteAheadLog::enlistLocks(this);
+        held.push_back(Range(start, end));
+        return true;
+    }
+
+    //--------------------------------------
+    // Applies mode to every byte not inside a held range (ScanLock).
+    bool lockGaps(LockMode mode) {
+        std::vector<Range> ranges(held);
+        std::sort(ranges.begin(), ranges.end());
+        bool ok = true;
+        long long from = 0;
+        for (const Range& r : ranges) {
+            if (r.first > from) ok = mf.lock(from, r.first - from, mode) && ok;
+            if (r.second == TAIL) return ok;
+            if (r.second > from) from = r.second;
+        }
+        return mf.lock(from, 0, mode) && ok;
+    }
+
+    //--------------------------------------
+    // Re-reads the file size if another handle resized the file since
+    // we last looked (or index is past what we know of).
+    void refreshFor(int index) {
+        unsigned long long layout = mf.changes(Change::LAYOUT);
+        if (layout != sizeSeen || index >= cachedCount()) {
+            sizeSeen = layout;
+            mf.refresh();
+        }
+    }
+
+    //--------------------------------------
+    // Bumps a shared change counter. Our own change keeps the owner's
+    // index current; one that lands after somebody else's does not.
+    void noteChange(Change kind) {
+        unsigned long long value = mf.noteChange(kind);
+        if (kind == Change::LAYOUT) {
+            if (sizeSeen + 1 == value) sizeSeen = value;
+            if (layoutSeen + 1 == value) layoutSeen = value;
+            if (cacheLayout + 1 == value) cacheLayout = value;
+        } else {
+            if (contentSeen + 1 == value) contentSeen = value;
+            if (cacheContent + 1 == value) cacheContent = value;
+        }
+    }
+
+    //--------------------------------------
+    // Epoch our cached pages must carry to be used: moves on when the
+    // counters changed other than through noteChange() (by another
+    // handle), which leaves every page cached so far stale.
+    unsigned long long cacheEpochNow() {
+        unsigned long long layout = mf.changes(Change::LAYOUT);
+        unsigned long long content = mf.changes(Change::CONTENT);
+        if (layout != cacheLayout || content != cacheContent) {
+            cacheLayout = layout;
+            cacheContent = content;
+            ++cacheEpoch;
+        }
+        return cacheEpoch;
+    }
+
+    //--------------------------------------
+    // Copies count records starting at first, just written to the
+    // mapping, into whichever of their pages are cached.
+    void writeThrough(int first, const T* records, int count) {
+        while (count > 0) {
+            int inPage = PAGE_RECORDS - first % PAGE_RECORDS;
+            int n = count < inPage ? count : inPage;
+            PageCache::write(cacheOwner, first / PAGE_RECORDS, cacheEpoch,
+                             static_cast<size_t>(first % PAGE_RECORDS) * sizeof(T), records, n * sizeof(T));
+            first += n;
+            records += n;
+            count -= n;
+        }
+    }
+
+    //--------------------------------------
+    // Record `index` from the page cache, or its whole page from the
+    // mapping under one shared lock (cached for the next reads). While
+    // this handle holds record locks a page lock could merge with them,
+    // so misses then fall back to readMapped().
+    bool readCached(int index, T& out) {
+        long long page = index / PAGE_RECORDS;
+        size_t at = static_cast<size_t>(index % PAGE_RECORDS) * sizeof(T);
+        refreshFor(index);
+        if (index >= cachedCount()) return false;
+        if (PageCache::read(cacheOwner, page, cacheEpochNow(), at, &out, sizeof(T))) {
+            IoTrace::note(IoOp::CACHE_READ, mf.path(), sizeof(T));
+            return true;
+        }
+        if (!held.empty()) return readMapped(index, out);
+
+        int first = static_cast<int>(page * PAGE_RECORDS);
+        long long offset = offsetOf(first);
+        long long bytes = static_cast<long long>(PAGE_RECORDS) * sizeof(T);
+        if (!mf.lock(offset, bytes, LockMode::SHARED)) return false;
+
+        refreshFor(index);
+        unsigned long long epoch = cacheEpochNow();     // changes committed before our lock
+        int count = cachedCount();
+        bool ok = index < count;
+        if (ok) {
+            int n = count - first < PAGE_RECORDS ? count - first : PAGE_RECORDS;
+            PageCache::fill(cacheOwner, page, epoch, mf.bytes() + offset, n * sizeof(T));
+            std::memcpy(&out, mf.bytes() + offsetOf(index), sizeof(T));
+            IoTrace::note(IoOp::READ, mf.path(), n * sizeof(T));
+        }
+
+        mf.lock(offset, bytes, LockMode::NONE);
+        return ok;
+    }
+
+    //--------------------------------------
+    // Copies committed record `index` from the mapping under a shared
+    // record lock (none needed when we hold it exclusively).
+    bool readMapped(int index, T& out) {
+        long long offset = offsetOf(index);
+        bool lockIt = !holds(offset, offset + sizeof(T));
+        if (lockIt && !mf.lock(offset, sizeof(T), LockMode::SHARED)) return false;
+
+        refreshFor(index);
+        bool ok = index < cachedCount();
+        if (ok) {
+            std::memcpy(&out, mf.bytes() + offset, sizeof(T));
+            IoTrace::note(IoOp::READ, mf.path(), sizeof(T));
+        }
+
+        if (lockIt) mf.lock(offset, sizeof(T), LockMode::NONE);
+        return ok;
+    }
+
+    //--------------------------------------
+    // In-memory mode: the exclusive lock on the whole file. Only tried,
+    // so a file another process has open fails here instead of waiting.
+    bool claimFile() {
+        if (mf.tryLock(0, 0, LockMode::EXCLUSIVE)) return true;
+        if (errno == EAGAIN) {
+            std::cerr << "[ERROR] " << mf.path() << ": store in use by another process." << std::endl;
+        }
+        return false;
+    }
+
+    //--------------------------------------
+    // In-memory mode: locks the whole file for this handle, reads every
+    // record into the table and enrolls with the writer.
+    bool loadTable() {
+        if (!claimFile()) return false;
+        mf.refresh();
+        int count = cachedCount();
+        table.resize(count);
+        if (count > 0 && !mf.readAt(HEADER_BYTES, table.data(), static_cast<long long>(count) * sizeof(T))) {
+            table.clear();
+            mf.lock(0, 0, LockMode::NONE);
+            return false;
+        }
+        dirty.clear();
+        dirtyMark.assign(count, false);
+        tableResized = false;
+        resident = true;
+        WriteBehind::enroll(this);
+        return true;
+    }
+
+    //--------------------------------------
+    // Sets the table to count records, zero-filling new ones, and marks
+    // those as changed (tableGuard held)
+    void resizeTable(int count) {
+        int before = static_cast<int>(table.size());
+        table.resize(count);
+        dirtyMark.resize(count, false);
+        if (count > before) markDirty(before, count - before);
+        tableResized = true;
+    }
+
+    //--------------------------------------
+    // Marks count records from first for the next write-back (tableGuard held)
+    void markDirty(int first, int count) {
+        for (int i = first; i < first + count; ++i) {
+            if (dirtyMark[i]) continue;
+            dirtyMark[i] = true;
+            dirty.push_back(i);
+        }
+    }
+
+public:
+    RecordFile()
+        : kind{ ' ', ' ', ' ', ' ' }, staging(false), stagedCount(0), stagedLowWater(0), stagedResize(false),
+          sizeSeen(0), layoutSeen(0), contentSeen(0),
+          cacheOwner(0), cacheEpoch(0), cacheLayout(0), cacheContent(0),
+          resident(false), tableResized(false) {}
+    ~RecordFile() { close(); }
+
+    //--------------------------------------
+    // Opens (creating if missing) a file of records of the given kind
+    // (four characters). Fails if the file has no header (run
+    // migrateRecordFile() first) or a header of something else.
+    bool open(const char* path, const char* recordKind) {
+        std::memcpy(kind, recordKind, sizeof(kind));
+        if (!mf.open(path)) return false;
+        // claimed before the header is checked, as that waits on its lock
+        if (WriteBehind::enabled() && !claimFile()) {
+            mf.close();
+            return false;
+        }
+
+        HeaderState state = mf.prepareHeader(makeHeader(kind, sizeof(T)));
+        if (state != HeaderState::CURRENT) {
+            std::cerr << "[ERROR] " << path
+                      << (state == HeaderState::LEGACY
+                          ? " is in the old record format and was not migrated."
+                          : " is not a current " + std::string(kind, sizeof(kind)) + " record file.")
+                      << std::endl;
+            mf.close();
+            return false;
+        }
+        sizeSeen = mf.changes(Change::LAYOUT);
+        markSynced();
+        cacheOwner = PageCache::newOwner();
+        cacheLayout = layoutSeen;
+        cacheContent = contentSeen;
+        if (WriteBehind::enabled() && !loadTable()) {
+            mf.close();
+            return false;
+        }
+        return true;
+    }
+
+    //--------------------------------------
+    // In-memory mode writes a snapshot of the table first.
+    void close() {
+        discardStaged();
+        if (resident) {
+            WriteBehind::withdraw(this);
+            writeBack(true);
+            resident = false;
+            std::vector<T>().swap(table);
+            dirty.clear();
+            dirtyMark.clear();
+        }
+        if (!held.empty()) {
+            releaseLocks();
+            WriteAheadLog::delistLocks(this);
+        }
+        mf.close();
+    }
+
+    bool isOpen() const { return mf.isOpen(); }
+    bool inMemory() const { return resident; }
+
+    //--------------------------------------
+    // False once the path names another file than the one mapped (it
+    // was renamed over on disk); the handle then needs reopening.
+    bool isCurrentFile() const { return mf.isCurrentFile(); }
+
+    //--------------------------------------
+    // Number of records, re-checked against the file (one fstat).
+    // Includes staged appends/truncates.
+    int size() {
+        if (staging) return stagedCount;
+        if (!resident) mf.refresh();
+        return cachedCount();
+    }
+
+    //--------------------------------------
+    // Typed span over the mapped records. Valid until the next call
+    // that may remap (append, truncate, size, get past the end).
+    // Shows committed records only; staged changes are visible via get().
+    // Walk it under a ScanLock.
+    const T* begin() const {
+        return resident ? table.data() : reinterpret_cast<const T*>(mf.bytes() + HEADER_BYTES);
+    }
+    const T* end() const { return begin() + cachedCount(); }
+
+    //--------------------------------------
+    // The same span as a key scan (see keyScan.h) over the field at
+    // offset, width bytes. Same rules as begin()..end().
+    KeyScan keys(size_t offset, size_t width) const {
+        KeyScan scan = { begin(), static_cast<size_t>(cachedCount()), sizeof(T), offset, width };
+        return scan;
+    }
+
+    //--------------------------------------
+    // True while this handle has staged changes, which a walk or key
+    // scan of the mapping does not see
+    bool hasStaged() const { return staging; }
+
+    //--------------------------------------
+    // Copies record `index` into out. Returns false if out of range.
+    bool get(int index, T& out) {
+        if (index < 0) return false;
+        if (staging) {
+            if (index >= stagedCount) return false;
+            typename std::map<int, T>::const_iterator it = stagedRecords.find(index);
+            if (it != stagedRecords.end()) {
+                out = it->second;
+                return true;
+            }
+            if (index >= stagedLowWater) {
+                std::memset(&out, 0, sizeof(T));
+                return true;
+            }
+        }
+        if (resident) {
+            if (index >= cachedCount()) return false;
+            out = table[index];
+            return true;
+        }
+        return PageCache::enabled() ? readCached(index, out) : readMapped(index, out);
+    }
+
+    //--------------------------------------
+    // Overwrites record `index` in place. Returns false if out of range.
+    bool update(int index, const T& record) {
+        if (index < 0 || !lockRecord(index)) return false;
+        if (stage()) {
+            if (index >= stagedCount) return false;
+            WriteAheadLog::logWrite(mf.path(), offsetOf(index), &record, sizeof(T));
+            stagedRecords[index] = record;
+            return true;
+        }
+        if (resident) {
+            if (index >= cachedCount()) return false;
+            WriteAheadLog::logWrite(mf.path(), offsetOf(index), &record, sizeof(T));
+            {
+                std::lock_guard<std::mutex> lock(tableGuard);
+                table[index] = record;
+                markDirty(index, 1);
+            }
+            noteChange(Change::CONTENT);
+            return true;
+        }
+        refreshFor(index);
+        if (index >= cachedCount()) return false;
+
+        long long offset = offsetOf(index);
+        WriteAheadLog::logWrite(mf.path(), offset, &record, sizeof(T));
+        std::memcpy(mf.bytes() + offset, &record, sizeof(T));
+        IoTrace::note(IoOp::WRITE, mf.path(), sizeof(T));
+        noteChange(Change::CONTENT);
+        writeThrough(index, &record, 1);
+        return true;
+    }
+
+    //--------------------------------------
+    // Appends one record. Returns its index, or -1 on failure.
+    int append(const T& record) {
+        return appendMany(&record, 1);
+    }
+
+    //--------------------------------------
+    // Appends count records with one resize, one log entry and one
+    // copy. Returns the index of the first, or -1 on failure.
+    int appendMany(const T* records, int count) {
+        if (count <= 0) return size();
+        int index = lockAppend();
+        if (index < 0) return -1;
+        long long offset = offsetOf(index);
+        long long bytes = static_cast<long long>(count) * sizeof(T);
+        bool staged = stage();
+        WriteAheadLog::logResize(mf.path(), offset + bytes);
+        WriteAheadLog::logWrite(mf.path(), offset, records, static_cast<unsigned int>(bytes));
+        if (staged) {
+            for (int i = 0; i < count; ++i) stagedRecords[index + i] = records[i];
+            stagedCount = index + count;
+            stagedResize = true;
+            return index;
+        }
+        if (resident) {
+            {
+                std::lock_guard<std::mutex> lock(tableGuard);
+                table.insert(table.end(), records, records + count);
+                dirtyMark.resize(table.size(), false);
+                markDirty(index, count);
+                tableResized = true;
+            }
+            noteChange(Change::LAYOUT);
+            return index;
+        }
+        if (!mf.resize(offset + bytes)) return -1;
+        std::memcpy(mf.bytes() + offset, records, bytes);
+        IoTrace::note(IoOp::WRITE, mf.path(), bytes);
+        noteChange(Change::LAYOUT);
+        writeThrough(index, records, count);
+        return index;
+    }
+
+    //--------------------------------------
+    // Shrinks (or grows, zero-filled) the file to numRecords records.
+    bool truncate(int numRecords) {
+        if (numRecords < 0) numRecords = 0;
+        int current = size();
+        if (!lockTail(numRecords < current ? numRecords : current)) return false;
+
+        long long bytes = offsetOf(numRecords);
+        bool staged = stage();
+        WriteAheadLog::logResize(mf.path(), bytes);
+        if (staged) {
+            stagedRecords.erase(stagedRecords.lower_bound(numRecords), stagedRecords.end());
+            stagedCount = numRecords;
+            stagedResize = true;
+            if (numRecords < stagedLowWater) stagedLowWater = numRecords;
+            return true;
+        }
+        if (resident) {
+            {
+                std::lock_guard<std::mutex> lock(tableGuard);
+                resizeTable(numRecords);
+            }
+            noteChange(Change::LAYOUT);
+            return true;
+        }
+        if (!mf.resize(bytes)) return false;
+        noteChange(Change::LAYOUT);
+        if (numRecords > current) ++cacheEpoch;     // zero-filled, cached pages may not be
+        return true;
+    }
+
+    //--------------------------------------
+    bool reset() { return truncate(0); }
+    bool flush() { return resident ? writeBack(false) : mf.flush(); }
+    bool sync() { return resident ? writeBack(true) : mf.sync(); }
+
+    //--------------------------------------
+    // Locks for a read-modify-write or a delete. Both are held until
+    // the operation commits or aborts; they are taken automatically by
+    // update(), append() and truncate(), and explicitly when a value
+    // must not change between being read and being written back.
+    //   lockRecord(i) - record i only
+    //   lockTail(i)   - record i, everything after it and the append
+    //                   position (lockTail(0) = every record, compaction)
+    bool lockRecord(int index) {
+        return index >= 0 && acquire(offsetOf(index), offsetOf(index + 1));
+    }
+
+    bool lockTail(int index) {
+        return index >= 0 && acquire(offsetOf(index), TAIL);
+    }
+
+    //--------------------------------------
+    // Locks the append position and returns the record count under the
+    // lock (the index the next append gets), or -1. Inside a transaction
+    // whose first resize this is, records appended by others since the
+    // transaction began are picked up first.
+    int lockAppend() {
+        if (staging && stagedResize) return stagedCount;
+        while (!resident) {
+            mf.refresh();
+            int count = cachedCount();
+            if (!lockTail(count)) return -1;
+            mf.refresh();
+            if (cachedCount() >= count) {          // nobody shrank it before we got the lock
+                sizeSeen = mf.changes(Change::LAYOUT);
+                break;
+            }
+        }
+        if (staging) {
+            stagedCount = stagedLowWater = cachedCount();
+            return stagedCount;
+        }
+        return cachedCount();
+    }
+
+    //--------------------------------------
+    // ScanLock support: shared lock on every byte not already held.
+    // (The trace counts the walk as reading every committed record.)
+    bool lockScan() {
+        if (resident) return true;
+        bool ok = lockGaps(LockMode::SHARED);
+        IoTrace::note(IoOp::SCAN, mf.path(), static_cast<long long>(cachedCount()) * sizeof(T));
+        return ok;
+    }
+    void unlockScan() {
+        if (!resident) lockGaps(LockMode::NONE);
+    }
+
+    //--------------------------------------
+    // Change detection for an in-memory index over this file: true if
+    // another handle changed the layout (or, with content, any record)
+    // since markSynced(). Changes made through this handle do not count.
+    bool changedElsewhere(bool content) const {
+        return mf.changes(Change::LAYOUT) != layoutSeen ||
+               (content && mf.changes(Change::CONTENT) != contentSeen);
+    }
+
+    void markSynced() {
+        layoutSeen = mf.changes(Change::LAYOUT);
+        contentSeen = mf.changes(Change::CONTENT);
+    }
+
+    //--------------------------------------
+    // StagedWriter: called by WriteAheadLog when the transaction ends.
+    // Apply replays the staged resizes and writes onto the mapping.
+    bool applyStaged() {
+        if (!staging) return true;
+        bool ok = true;
+        bool resized = stagedLowWater < cachedCount() || stagedCount != cachedCount();
+        if (resident) {
+            {
+                std::lock_guard<std::mutex> lock(tableGuard);
+                if (stagedLowWater < cachedCount()) resizeTable(stagedLowWater);
+                if (resized) resizeTable(stagedCount);
+                for (const auto& entry : stagedRecords) {
+                    table[entry.first] = entry.second;
+                    markDirty(entry.first, 1);
+                }
+            }
+            if (resized) noteChange(Change::LAYOUT);
+            if (!stagedRecords.empty()) noteChange(Change::CONTENT);
+            staging = false;
+            stagedRecords.clear();
+            return true;
+        }
+        if (stagedLowWater < cachedCount())
+            ok = mf.resize(offsetOf(stagedLowWater));
+        ok = ok && mf.resize(offsetOf(stagedCount));
+        if (ok) {
+            for (const auto& entry : stagedRecords) {
+                std::memcpy(mf.bytes() + offsetOf(entry.first), &entry.second, sizeof(T));
+            }
+            if (!stagedRecords.empty())
+                IoTrace::note(IoOp::WRITE, mf.path(), static_cast<long long>(stagedRecords.size() * sizeof(T)));
+            if (resized) noteChange(Change::LAYOUT);
+            if (!stagedRecords.empty()) noteChange(Change::CONTENT);
+
+            // records between the low-water mark and the new end that
+            // were not written are zero-filled, and not in the cache
+            long long written = std::distance(stagedRecords.lower_bound(stagedLowWater), stagedRecords.end());
+            if (written < stagedCount - stagedLowWater) ++cacheEpoch;
+            for (const auto& entry : stagedRecords) writeThrough(entry.first, &entry.second, 1);
+        }
+        staging = false;
+        stagedRecords.clear();
+        return ok;
+    }
+
+    void discardStaged() {
+        if (!staging) return;
+        WriteAheadLog::delist(this);
+        staging = false;
+        stagedRecords.clear();
+    }
+
+    void releaseLocks() {
+        if (held.empty()) return;
+        mf.lock(0, 0, LockMode::NONE);
+        held.clear();
+    }
+
+    //--------------------------------------
+    // WriteBehindTable: copies the changed records (in runs of adjacent
+    // ones) or, for a snapshot, the whole table into the mapping, then
+    // flushes it (a snapshot waits for the disk). Without a table it
+    // is flush() / sync().
+    bool writeBack(bool snapshot) {
+        if (!resident) return snapshot ? mf.sync() : mf.flush();
+        std::lock_guard<std::mutex> lock(tableGuard);
+        if (!snapshot && dirty.empty() && !tableResized) return true;
+
+        int count = cachedCount();
+        if ((tableResized || mf.size() != offsetOf(count)) && !mf.resize(offsetOf(count))) return false;
+        long long written = 0;
+        if (snapshot) {
+            written = static_cast<long long>(count) * sizeof(T);
+            if (count > 0) std::memcpy(mf.bytes() + HEADER_BYTES, table.data(), written);
+        } else {
+            std::sort(dirty.begin(), dirty.end());
+            size_t i = 0;
+            while (i < dirty.size() && dirty[i] < count) {
+                size_t last = i;
+                while (last + 1 < dirty.size() && dirty[last + 1] == dirty[last] + 1 && dirty[last + 1] < count) ++last;
+                long long bytes = static_cast<long long>(last - i + 1) * sizeof(T);
+                std::memcpy(mf.bytes() + offsetOf(dirty[i]), &table[dirty[i]], bytes);
+                written += bytes;
+                i = last + 1;
+            }
+        }
+        if (written > 0) IoTrace::note(IoOp::WRITE, mf.path(), written);
+
+        for (int index : dirty) {
+            if (index < count) dirtyMark[index] = false;
+        }
+        dirty.clear();
+        tableResized = false;
+        return snapshot ? mf.sync() : mf.flush();
+    }
+};
+
+//--------------------------------------
+// Class: ScanLock<T>
+// Shared lock over a whole RecordFile for the length of a pointer walk,
+// so no other process can shrink the file under the mapping mid-walk.
+// Ranges the handle already holds exclusively are left as they are.
+template <typename T>
+class ScanLock {
+private:
+    RecordFile<T>& file;
+
+public:
+    explicit ScanLock(RecordFile<T>& f) : file(f) { file.lockScan(); }
+    ~ScanLock() { file.unlockScan(); }
+    ScanLock(const ScanLock&) = delete;
+    ScanLock& operator=(const ScanLock&) = delete;
+};
+
+//--------------------------------------
+// Converts a format v1 file (bare Old records, no header) at path into
+// the current format: each record goes through convert (false drops
+// it), the result gets a header of the given kind and replaces the
+// file, and the old file is kept as <path>.v1. Files that are empty or
+// already have a header are left alone. Runs under an exclusive lock
+// on the old file, so concurrent start-ups migrate it once (in
+// in-memory mode the lock is only tried, and open() then reports a
+// file in use).
+// If migrated is given, it is set to whether the file was converted.
+// Returns false if the file could not be read or replaced.
+template <typename Old, typename New>
+bool migrateRecordFile(const char* path, const char* kind,
+                       const std::function<bool(const Old&, New&)>& convert,
+                       bool* migrated = nullptr) {
+    FileHeader header = makeHeader(kind, sizeof(New));
+    if (migrated) *migrated = false;
+
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        MappedFile mf;
+        if (!mf.open(path)) return false;
+        if (!(WriteBehind::enabled() ? mf.tryLock(0, 0, LockMode::EXCLUSIVE)
+                                     : mf.lock(0, 0, LockMode::EXCLUSIVE))) return false;
+        if (!mf.isCurrentFile()) continue;      // migrated while we waited
+        mf.refresh();
+        if (mf.headerState(header) != HeaderState::LEGACY) return true;
+
+        if (mf.size() % static_cast<long long>(sizeof(Old)) != 0) {
+            std::cerr << "[ERROR] " << path << " is not a record file of this system; left as it is." << std::endl;
+            return false;
+        }
+
+        long long count = mf.size() / static_cast<long long>(sizeof(Old));
+        const Old* records = reinterpret_cast<const Old*>(mf.bytes());
+        std::vector<New> rows;
+        rows.reserve(static_cast<size_t>(count));
+        for (long long i = 0; i < count; ++i) {
+            New row;
+            std::memset(&row, 0, sizeof(row));
+            if (convert(records[i], row)) rows.push_back(row);
+        }
+
+        std::string backup = std::string(path) + ".v1";
+        if (!mf.replaceWith(header, rows.data(), static_cast<long long>(rows.size() * sizeof(New)), backup))
+            return false;
+        if (migrated) *migrated = true;
+        std::cout << "[System] Migrated " << path << " to record format v" << RECORD_FORMAT_VERSION
+                  << " (" << rows.size() << " of " << count << " records; old file kept as "
+                  << backup << ")." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+#endif // RECORD_FILE_H
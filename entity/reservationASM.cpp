@@ -21,25 +21,87 @@
 //***************************************************
 
 #include "reservationASM.h"
-#include <fstream>
+#include "sailingASM.h"
+#include "../system/latencyStats.h"
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 
 using namespace std;
 
+#define FILE_KIND "RESV"
+
+namespace {
+    // reservations.dat record before format v2
+    struct ReservationV1 {
+        char sailingId[10];
+        char licensePlate[11];
+        bool isOnboard;
+        char laneUsed;
+    };
+}
+
+//--------------------------------------
+// Convert a v1 file, then open it
+bool ReservationASM::openFile() {
+    migrateRecordFile<ReservationV1, ReservationRow>(filename, FILE_KIND,
+        [](const ReservationV1& old, ReservationRow& row) {
+            ReservationRecord record{};
+            memcpy(record.sailingId, old.sailingId, sizeof(record.sailingId));
+            memcpy(record.licensePlate, old.licensePlate, sizeof(record.licensePlate));
+            record.sailingId[sizeof(record.sailingId) - 1] = '\0';
+            record.licensePlate[sizeof(record.licensePlate) - 1] = '\0';
+            record.isOnboard = old.isOnboard;
+            record.laneUsed = old.laneUsed;
+            if (!packRow(record, row)) {
+                cerr << "[WARN] Dropped reservation for " << record.licensePlate
+                     << " with invalid sailing ID \"" << record.sailingId << "\" during migration." << endl;
+                return false;
+            }
+            return true;
+        }, &migrated);
+    return file.open(filename, FILE_KIND);
+}
+
+//--------------------------------------
+bool ReservationASM::wasMigrated() const {
+    return migrated;
+}
+
+//--------------------------------------
+// Record <-> row conversion. Fails if the sailing ID is malformed.
+bool ReservationASM::packRow(const ReservationRecord& record, ReservationRow& row) {
+    memset(&row, 0, sizeof(row));
+    row.sailingKey = SailingASM::packSailingId(record.sailingId);
+    if (row.sailingKey < 0) return false;
+
+    memcpy(row.licensePlate, record.licensePlate, strnlen(record.licensePlate, sizeof(row.licensePlate)));
+    row.laneUsed = (record.laneUsed == 'H') ? 'H' : 'L';
+    row.isOnboard = record.isOnboard;
+    return true;
+}
+
+void ReservationASM::unpackRow(const ReservationRow& row, ReservationRecord& record) {
+    memset(&record, 0, sizeof(record));
+    SailingASM::unpackSailingId(row.sailingKey, record.sailingId);
+    memcpy(record.licensePlate, row.licensePlate, sizeof(row.licensePlate));
+    record.isOnboard = row.isOnboard;
+    record.laneUsed = row.laneUsed;
+}
+
+string ReservationASM::plateKey(const ReservationRow& row) {
+    return string(row.licensePlate, strnlen(row.licensePlate, sizeof(row.licensePlate)));
+}
+
 //--------------------------------------
 // Open or create reservation file
-void ReservationASM::initialize() {
-    file.open(filename, ios::in | ios::out | ios::binary);
-    if (!file) {
-        file.clear();
-        file.open(filename, ios::out | ios::binary);
-        file.close();
-        file.open(filename, ios::in | ios::out | ios::binary);
-    }
-    if (!file.good()) {
+bool ReservationASM::initialize() {
+    bool opened = openFile();
+    if (!opened) {
         cerr << "ReservationASM Error: Could not open file." << endl;
     }
+    rebuildIndex();
+    return opened;
 }
 
 //--------------------------------------
@@ -48,58 +110,100 @@ void ReservationASM::shutdown() {
     file.close();
 }
 
+//--------------------------------------
+// A mapping of a replaced file would never see its changes
+bool ReservationASM::reopenIfReplaced() {
+    if (!file.isOpen() || file.isCurrentFile()) return false;
+    file.close();
+    if (!openFile()) {
+        cerr << "ReservationASM Error: Could not reopen file." << endl;
+    }
+    rebuildIndex();
+    return true;
+}
+
 // Reset file
 void ReservationASM::reset() {
-    if (file.is_open()) file.close();
-
-    ofstream resetFile(filename, ios::out | ios::trunc | ios::binary);
-    if (resetFile.is_open()) resetFile.close();
-    else {
+    if (!file.isOpen() && !openFile()) {
         cerr << "Could not reset the Reservation file." << endl;
         return;
     }
+    if (!file.reset()) {
+        cerr << "Could not reset the Reservation file." << endl;
+    }
 
-    file.open(filename, ios::in | ios::out | ios::binary);
+    plateIndex.clear();
+    indexedCount = 0;
+}
 
-    // make sure file is open
-    if (!file) {
-        cerr << "ReservationASM: File could not be reopened." << endl;
+//--------------------------------------
+// Walk the mapped records once and rebuild plate -> indexes map
+void ReservationASM::rebuildIndex() {
+    plateIndex.clear();
+    indexedCount = 0;
+
+    ScanLock<ReservationRow> scan(file);
+    file.markSynced();
+    file.size();    // pick up the current length before walking
+    for (const ReservationRow* r = file.begin(); r != file.end(); ++r) {
+        plateIndex[plateKey(*r)].push_back(indexedCount);
+        ++indexedCount;
     }
 }
 
+//--------------------------------------
+// Another handle (here or in another process) may have appended, moved
+// or deleted records. Check-ins do not move records, so only layout
+// changes count.
+void ReservationASM::syncIndex() {
+    if (getRecordCount() != indexedCount || file.changedElsewhere(false)) {
+        rebuildIndex();
+    }
+}
+
+//--------------------------------------
+// Add index to plate's list, keeping it sorted
+void ReservationASM::indexInsert(const string& plate, int index) {
+    std::vector<int>& slots = plateIndex[plate];
+    slots.insert(lower_bound(slots.begin(), slots.end(), index), index);
+}
+
+//--------------------------------------
+// Remove index from plate's list (drop the key when empty)
+void ReservationASM::indexErase(const string& plate, int index) {
+    auto it = plateIndex.find(plate);
+    if (it == plateIndex.end()) return;
+
+    std::vector<int>& slots = it->second;
+    auto pos = lower_bound(slots.begin(), slots.end(), index);
+    if (pos != slots.end() && *pos == index) slots.erase(pos);
+    if (slots.empty()) plateIndex.erase(it);
+}
+
 //--------------------------------------
 // Return total number of reservations
 int ReservationASM::getRecordCount() {
-    file.clear();
-    file.seekg(0, ios::end);
-    auto endPos = file.tellg();
-    return (endPos > 0) ? static_cast<int>(endPos / sizeof(ReservationRecord)) : 0;
+    return file.size();
 }
 
 //--------------------------------------
 // Return reservation by index
 ReservationRecord ReservationASM::get(int index) {
-    file.clear();
+    static LatencyProbe latencyProbe("reservationASM.get");
+    LatencyTimer timer(latencyProbe);
     ReservationRecord record{};
-    file.seekg(index * sizeof(ReservationRecord), ios::beg);
-    file.read(reinterpret_cast<char*>(&record), sizeof(record));
+    ReservationRow row;
+    if (file.get(index, row)) unpackRow(row, record);
     return record;
 }
 
 //--------------------------------------
 // Find first reservation matching license plate
 int ReservationASM::findIndexByLicense(const char* plate) {
-    file.clear();
-    file.seekg(0, ios::beg);
-    ReservationRecord record{};
-    int idx = 0;
-    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
-        if (strcmp(record.licensePlate, plate) == 0) {
-            return idx;
-        }
-        ++idx;
-    }
-    return -1;
+    syncIndex();
+    auto it = plateIndex.find(plate);
+    if (it == plateIndex.end() || it->second.empty()) return -1;
+    return it->second.front();
 }
 
 //--------------------------------------
@@ -108,6 +212,8 @@ bool ReservationASM::writeReservationRecord(const char* licensePlate,
                                             const char* sailingID,
                                             bool isOnboard,
                                             char laneUsed) {
+    static LatencyProbe latencyProbe("reservationASM.writeReservationRecord");
+    LatencyTimer timer(latencyProbe);
     // Normalize laneUsed
     if (laneUsed != 'H' && laneUsed != 'L') laneUsed = 'L';
 
@@ -117,11 +223,40 @@ bool ReservationASM::writeReservationRecord(const char* licensePlate,
     record.isOnboard = isOnboard;
     record.laneUsed  = laneUsed;
 
-    file.clear();
-    file.seekp(0, ios::end);
-    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
-    file.flush();
-    return file.good();
+    ReservationRow row;
+    if (!packRow(record, row)) return false;
+
+    syncIndex();
+
+    int idx = file.append(row);
+    if (idx < 0) return false;
+
+    indexInsert(plateKey(row), idx);
+    indexedCount = idx + 1;
+    return true;
+}
+
+//--------------------------------------
+// Append many reservations with a single resize and copy
+bool ReservationASM::writeReservationRecords(const std::vector<ReservationRecord>& records) {
+    static LatencyProbe latencyProbe("reservationASM.writeReservationRecords");
+    LatencyTimer timer(latencyProbe);
+    if (records.empty()) return true;
+
+    std::vector<ReservationRow> rows(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!packRow(records[i], rows[i])) return false;
+    }
+    syncIndex();
+
+    int first = file.appendMany(rows.data(), static_cast<int>(rows.size()));
+    if (first < 0) return false;
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        indexInsert(plateKey(rows[i]), first + static_cast<int>(i));
+    }
+    indexedCount = first + static_cast<int>(records.size());
+    return true;
 }
 
 //--------------------------------------
@@ -146,68 +281,49 @@ bool ReservationASM::checkInReservation(const char* licensePlate) {
     int idx = findIndexByLicense(licensePlate);
     if (idx < 0) return false;
 
-    ReservationRecord record = get(idx);
-    record.isOnboard = true;
-
-    file.clear();
-    file.seekp(idx * sizeof(record), ios::beg);
-    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
-    file.flush();
-    return file.good();
+    return checkInReservationByIndex(idx);
 }
 
 //--------------------------------------
 // Delete reservation by license (overwrite with last)
 bool ReservationASM::deleteReservationRecord(const char* licensePlate) {
-    int count = getRecordCount();
-    if (count == 0) return false;
-
     int target = findIndexByLicense(licensePlate);
     if (target < 0) return false;
 
-    if (target != count - 1) {
-        ReservationRecord last = get(count - 1);
-        file.clear();
-        file.seekp(target * sizeof(last), ios::beg);
-        file.write(reinterpret_cast<const char*>(&last), sizeof(last));
-    }
-
-    file.flush();
-    file.close();
-    truncateFile(count - 1);
-    file.open(filename, ios::in | ios::out | ios::binary);
-    return true;
+    return deleteReservationByIndex(target);
 }
 
 //--------------------------------------
-// Remove trailing records by rewriting N records
+// Drop trailing records by shrinking the file in place
+// (index entries pointing past the new end are dropped as well)
 void ReservationASM::truncateFile(int numRecords) {
+    static LatencyProbe latencyProbe("reservationASM.truncateFile");
+    LatencyTimer timer(latencyProbe);
     if (numRecords < 0) numRecords = 0;
 
-    fstream oldF(filename, ios::in | ios::binary);
-    fstream newF("temp.dat", ios::out | ios::binary);
-    ReservationRecord temp{};
-
-    for (int i = 0; i < numRecords && oldF.read(reinterpret_cast<char*>(&temp), sizeof(temp)); ++i) {
-        newF.write(reinterpret_cast<const char*>(&temp), sizeof(temp));
+    int count = getRecordCount();
+    for (int i = numRecords; i < count; ++i) {
+        ReservationRow temp;
+        if (file.get(i, temp)) indexErase(plateKey(temp), i);
     }
+    if (indexedCount > numRecords) indexedCount = numRecords;
 
-    oldF.close();
-    newF.close();
-    remove(filename);
-    rename("temp.dat", filename);
+    file.truncate(numRecords);
 }
 
 //--------------------------------------
 // Check if exact reservation exists
 bool ReservationASM::existsReservation(const char* licensePlate, const char* sailingID) {
-    file.clear();
-    file.seekg(0, ios::beg);
-    ReservationRecord record{};
-
-    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
-        if (strcmp(record.licensePlate, licensePlate) == 0 &&
-            strcmp(record.sailingId,    sailingID)    == 0) {
+    static LatencyProbe latencyProbe("reservationASM.existsReservation");
+    LatencyTimer timer(latencyProbe);
+    syncIndex();
+    auto it = plateIndex.find(licensePlate);
+    if (it == plateIndex.end()) return false;
+
+    int key = SailingASM::packSailingId(sailingID);
+    for (int idx : it->second) {
+        ReservationRow row;
+        if (file.get(idx, row) && row.sailingKey == key) {
             return true;
         }
     }
@@ -217,55 +333,168 @@ bool ReservationASM::existsReservation(const char* licensePlate, const char* sai
 //--------------------------------------
 // Find all indexes with matching license
 std::vector<int> ReservationASM::findAllIndexesByLicense(const char* plate) {
-    file.clear();
-    file.seekg(0, ios::beg);
-
-    std::vector<int> indexes;
-    ReservationRecord record{};
-    int idx = 0;
-
-    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
-        if (strcmp(record.licensePlate, plate) == 0) {
-            indexes.push_back(idx);
-        }
-        ++idx;
-    }
-
-    return indexes;
+    static LatencyProbe latencyProbe("reservationASM.findAllIndexesByLicense");
+    LatencyTimer timer(latencyProbe);
+    syncIndex();
+    auto it = plateIndex.find(plate);
+    if (it == plateIndex.end()) return std::vector<int>();
+    return it->second;
 }
 
 //--------------------------------------
 // Mark reservation as onboard by index
 bool ReservationASM::checkInReservationByIndex(int index) {
+    static LatencyProbe latencyProbe("reservationASM.checkInReservationByIndex");
+    LatencyTimer timer(latencyProbe);
     int count = getRecordCount();
     if (index < 0 || index >= count) return false;
 
-    ReservationRecord record = get(index);
-    record.isOnboard = true;
-
-    file.clear();
-    file.seekp(index * sizeof(record), ios::beg);
-    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
-    file.flush();
-    return file.good();
+    ReservationRow row;
+    if (!file.get(index, row)) return false;
+    row.isOnboard = true;
+    return file.update(index, row);
 }
 
 //--------------------------------------
 // Delete reservation by index
 bool ReservationASM::deleteReservationByIndex(int target) {
+    static LatencyProbe latencyProbe("reservationASM.deleteReservationByIndex");
+    LatencyTimer timer(latencyProbe);
+    // the slot and everything after it move or go: lock before counting
+    if (!file.lockTail(target)) return false;
     int count = getRecordCount();
-    if (target < 0 || target >= count) return false;
+    if (target >= count) return false;
+
+    syncIndex();
+    ReservationRow removed;
+    if (file.get(target, removed)) indexErase(plateKey(removed), target);
 
     if (target != count - 1) {
-        ReservationRecord last = get(count - 1);
-        file.clear();
-        file.seekp(target * sizeof(last), ios::beg);
-        file.write(reinterpret_cast<const char*>(&last), sizeof(last));
+        ReservationRow last;
+        if (file.get(count - 1, last)) {
+            file.update(target, last);
+            indexInsert(plateKey(last), target);
+        }
     }
 
-    file.flush();
-    file.close();
     truncateFile(count - 1);
-    file.open(filename, ios::in | ios::out | ios::binary);
     return true;
 }
+
+//--------------------------------------
+// Compare one field of every row with key: one key scan over the
+// mapping, or row by row through get() while changes are staged
+std::vector<int> ReservationASM::scanRows(size_t offset, size_t width, const void* key,
+                                          std::vector<ReservationRow>* rows) {
+    std::vector<int> hits;
+    if (file.hasStaged()) {
+        int count = getRecordCount();
+        for (int i = 0; i < count; ++i) {
+            ReservationRow row;
+            if (!file.get(i, row) || memcmp(reinterpret_cast<const char*>(&row) + offset, key, width) != 0) continue;
+            hits.push_back(i);
+            if (rows) rows->push_back(row);
+        }
+        return hits;
+    }
+
+    ScanLock<ReservationRow> scan(file);
+    file.size();    // pick up the current length before scanning
+    scanEqual(file.keys(offset, width), key, hits);
+    if (rows) {
+        for (int i : hits) rows->push_back(file.begin()[i]);
+    }
+    return hits;
+}
+
+//--------------------------------------
+// Delete the reservations of a sailing (optionally of one vehicle).
+// The sailing key and plate are adjacent in a row, so both are one
+// 14-byte key. Survivors after the first victim slide down over the
+// holes (order kept), then the file is shrunk once.
+int ReservationASM::deleteBySailing(const char* sailingID, const char* licensePlate) {
+    static LatencyProbe latencyProbe("reservationASM.deleteBySailing");
+    LatencyTimer timer(latencyProbe);
+    ReservationRecord probe{};
+    strncpy(probe.sailingId, sailingID, sizeof(probe.sailingId) - 1);
+    if (licensePlate) strncpy(probe.licensePlate, licensePlate, sizeof(probe.licensePlate) - 1);
+    ReservationRow key;
+    if (!packRow(probe, key)) return 0;
+    size_t width = licensePlate ? offsetof(ReservationRow, laneUsed) : sizeof(key.sailingKey);
+
+    // compaction rewrites the whole file
+    if (!file.lockTail(0)) return -1;
+    syncIndex();
+    std::vector<int> victims = scanRows(offsetof(ReservationRow, sailingKey), width, &key);
+    if (victims.empty()) return 0;
+
+    int count = getRecordCount();
+    int writePos = victims.front();
+    size_t next = 0;
+    for (int readPos = victims.front(); readPos < count; ++readPos) {
+        ReservationRow row;
+        if (!file.get(readPos, row)) return -1;
+        string plate = plateKey(row);
+
+        if (next < victims.size() && victims[next] == readPos) {
+            ++next;
+            indexErase(plate, readPos);
+            continue;
+        }
+        // Write cursor never passes the read cursor, so this is safe in place
+        if (writePos != readPos) {
+            if (!file.update(writePos, row)) return -1;
+            indexErase(plate, readPos);
+            indexInsert(plate, writePos);
+        }
+        ++writePos;
+    }
+
+    if (!file.truncate(writePos)) return -1;
+    indexedCount = writePos;
+    return count - writePos;
+}
+
+//--------------------------------------
+// Count checked-in reservations per sailing from one key scan of the
+// onboard flags
+void ReservationASM::tallyOnboard(std::unordered_map<int, int>& perSailing) {
+    static LatencyProbe latencyProbe("reservationASM.tallyOnboard");
+    LatencyTimer timer(latencyProbe);
+    const bool onboard = true;
+    std::vector<ReservationRow> rows;
+    scanRows(offsetof(ReservationRow, isOnboard), sizeof(onboard), &onboard, &rows);
+    for (const ReservationRow& row : rows) {
+        ++perSailing[row.sailingKey];
+    }
+}
+
+//--------------------------------------
+// Index lookup, then lock, then confirm the slot still holds the booking
+int ReservationASM::lockReservation(const char* licensePlate, const char* sailingID) {
+    int key = SailingASM::packSailingId(sailingID);
+    if (key < 0) return -1;
+
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        int found = -1;
+        ReservationRow row;
+        for (int idx : findAllIndexesByLicense(licensePlate)) {
+            if (file.get(idx, row) && row.sailingKey == key) {
+                found = idx;
+                break;
+            }
+        }
+        if (found < 0 || !file.lockRecord(found)) return -1;
+
+        if (file.get(found, row) && plateKey(row) == licensePlate && row.sailingKey == key) {
+            return found;
+        }
+        // moved while we waited; the next lookup sees the change
+    }
+    return -1;
+}
+
+//--------------------------------------
+bool ReservationASM::lockAll() {
+    return file.lockTail(0);
+}
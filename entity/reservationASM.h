@@ -19,13 +19,18 @@
 // Purpose:
 //   Stores and retrieves reservation records from disk.
 //   Used by ReservationManager and Check-in procedures.
+//   On disk a reservation is a packed 16-byte ReservationRow (format
+//   v2); callers see the unpacked ReservationRecord.
 //***************************************************
 
 #ifndef RESERVATION_ASM_H
 #define RESERVATION_ASM_H
 
-#include <fstream>
 #include <vector>
+#include <string>
+#include <cstddef>
+#include <unordered_map>
+#include "recordFile.h"
 
 //--------------------------------------
 // Structure: ReservationRecord
@@ -36,22 +41,52 @@ struct ReservationRecord {
     char laneUsed;            // 'H' (HRL) or 'L' (LRL). For regular vehicles that fell back to HRL, this will be 'H'.
 };
 
+//--------------------------------------
+// Structure: ReservationRow (as stored in reservations.dat)
+struct ReservationRow {
+    int sailingKey;           // SailingASM::packSailingId() of the sailing ID
+    char licensePlate[10];    // Max 10 chars, '\0'-padded (no terminator when full)
+    char laneUsed;            // 'H' or 'L'
+    bool isOnboard;           // Check-in status
+};
+
 //--------------------------------------
 // Class: ReservationASM
 class ReservationASM {
 private:
     const char* filename = "reservations.dat";
-    std::fstream file;
+    RecordFile<ReservationRow> file;
 
+    // Plate -> ascending record indexes. Rebuilt on initialize() and kept in
+    // step with every write/delete so plate lookups never scan the file.
+    std::unordered_map<std::string, std::vector<int>> plateIndex;
+    int indexedCount = 0;                // number of records covered by plateIndex
+
+    bool openFile();                     // Migrate a v1 file, then open
+    bool migrated = false;               // openFile() converted a v1 file
     void truncateFile(int numRecords);
+    void rebuildIndex();                 // Full scan to repopulate plateIndex
+    void syncIndex();                    // Rebuild if another handle moved records
+    void indexInsert(const std::string& plate, int index);
+    void indexErase(const std::string& plate, int index);
+    std::vector<int> scanRows(          // Key scan of one row field (see keyScan.h);
+        size_t offset, size_t width,    // rows also copies the matching rows
+        const void* key,
+        std::vector<ReservationRow>* rows = nullptr);
+
+    static bool packRow(const ReservationRecord& record, ReservationRow& row);
+    static void unpackRow(const ReservationRow& row, ReservationRecord& record);
+    static std::string plateKey(const ReservationRow& row);   // stored plate as a key
 
 public:
     //======================
     // FI: File Initialization
-    void initialize();                  // Open or create reservation file
+    bool initialize();                  // Open or create reservation file (false on failure)
     void shutdown();                    // Close reservation file
+    bool reopenIfReplaced();            // Reopen and re-index if the path was renamed over
     void reset();                       // Clear the reservation data
     int  getRecordCount();              // Return total reservation count
+    bool wasMigrated() const;           // Opening converted a v1 file
 
     //======================
     // MO: Modification Operations
@@ -62,6 +97,9 @@ public:
         char laneUsed = 'L'            // 'H' or 'L'. Default 'L' for regular case.
     );
 
+    bool writeReservationRecords(       // Append a batch in one write (bulk import)
+        const std::vector<ReservationRecord>& records
+    );
     bool readReservationRecord(         // Read reservation by license plate (first match)
         const char* licensePlate,
         char* sailingID,
@@ -90,6 +128,25 @@ public:
 
     bool checkInReservationByIndex(int index);                  // Check-in using index
     bool deleteReservationByIndex(int index);                   // Delete using index
+
+    //======================
+    // Locking (held until the operation commits, see recordFile.h)
+    int lockReservation(                                        // Find and lock for update,
+        const char* licensePlate,                               // re-checked under the lock;
+        const char* sailingID                                   // returns index or -1
+    );
+    bool lockAll();                                             // Whole file (bulk import)
+
+    int deleteBySailing(                                        // Bulk delete, returns removed count
+        const char* sailingID,                                  // every reservation on the sailing,
+        const char* licensePlate = nullptr                      // or only this vehicle's
+    );  // Key scan for the victims, then survivors from the first one on are
+        // compacted in order and the file shrunk once; -1 if a lock or
+        // write failed (the caller's transaction must then abort)
+
+    void tallyOnboard(                                          // Adds the checked-in reservations
+        std::unordered_map<int, int>& perSailing                // per packed sailing ID (key scan)
+    );
 };
 
 #endif // RESERVATION_ASM_H
@@ -3,171 +3,533 @@
 // SailingASM.cpp
 // Version: 2.0
 // Author: Wenbo Zhang
-// Purpose: Header file for SailingASM class.
-// Provides binary record-based file access for fixed-length SailingRecord.
+// Purpose: Implementation of the SailingASM class.
+// Provides binary record-based file access for fixed-length sailing
+// records, converting between SailingRow and SailingRecord.
 //***************************************************
 
 #include "sailingASM.h"
+#include "ferryASM.h"
+#include "../system/latencyStats.h"
 #include <iostream>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 using namespace std;
 
-//-------------------------------------------------------------
-// Initializes the binary file for sailing records
-void SailingASM::initialize() {
-    file.open(filename, ios::in | ios::out | ios::binary);
-    if (!file.is_open()) {
-        // file.clear();
-        file.open(filename, ios::out | ios::binary);  // Create empty file
-        file.close();
-        file.open(filename, ios::in | ios::out | ios::binary);
+#define FILE_KIND "SAIL"
+
+namespace {
+    // sailings.dat record before format v2
+    struct SailingV1 {
+        char date[DATE_LEN];
+        char ferryName[NAME_LEN];
+        float highLaneRestLength;
+        float lowLaneRestLength;
+        int onboardVehicleCount;
+    };
+
+    // Lane lengths and counts are stored as unsigned shorts
+    unsigned short clampShort(int value) {
+        return static_cast<unsigned short>(max(0, min(value, 65535)));
     }
 
-    if (!file.good()) {
+    // Ferry ID of the named ferry, 0 if there is none
+    int ferryIdOf(const char* ferryName) {
+        Ferry ferry;
+        char name[NAME_LEN];
+        strncpy(name, ferryName, NAME_LEN - 1);
+        name[NAME_LEN - 1] = '\0';
+        return FerryASM::findFerry(name, ferry) ? ferry.ferryId : 0;
+    }
+}
+
+//-------------------------------------------------------------
+// Converts a v1 file (ferry names become ferry IDs, so ferries.dat
+// must be migrated first), then opens it
+bool SailingASM::openFile() {
+    migrateRecordFile<SailingV1, SailingRow>(filename, FILE_KIND, [](const SailingV1& old, SailingRow& row) {
+        char date[DATE_LEN];
+        memcpy(date, old.date, DATE_LEN);
+        date[DATE_LEN - 1] = '\0';
+        row.sailingKey = packSailingId(date);
+        if (row.sailingKey < 0) {
+            cerr << "[WARN] Dropped sailing with invalid ID \"" << date << "\" during migration." << endl;
+            return false;
+        }
+        row.ferryId = static_cast<unsigned short>(ferryIdOf(old.ferryName));
+        if (row.ferryId == 0) {
+            cerr << "[WARN] Sailing " << date << " refers to an unknown ferry; kept without one." << endl;
+        }
+        row.highLaneDm = clampShort(toDecimetres(old.highLaneRestLength));
+        row.lowLaneDm = clampShort(toDecimetres(old.lowLaneRestLength));
+        row.onboard = clampShort(old.onboardVehicleCount);
+        return true;
+    }, &migrated);
+    return file.open(filename, FILE_KIND);
+}
+
+//--------------------------------------
+bool SailingASM::wasMigrated() const {
+    return migrated;
+}
+
+//-------------------------------------------------------------
+// Initializes the binary file for sailing records
+bool SailingASM::initialize() {
+    bool opened = openFile();
+    if (!opened) {
         cerr << "SailingASM Error: Could not open file." << endl;
     }
+    rebuildIndex();
+    return opened;
 }
 
 void SailingASM::reset() {
-    if (file.is_open()) file.close();
-
-    ofstream resetFile(filename, ios::out | ios::trunc | ios::binary);
-    
-    if (resetFile.is_open()) resetFile.close();
-    else {
+    if (!file.isOpen() && !openFile()) {
         cerr << "Could not reset the Sailing file." << endl;
         return;
     }
+    if (!file.reset()) {
+        cerr << "Could not reset the Sailing file." << endl;
+    }
+
+    idIndex.clear();
+    slotKeys.clear();
+    ferryIndex.clear();
+    slotFerries.clear();
+    slotHigh.clear();
+    slotLow.clear();
+    highRoom.clear();
+    lowRoom.clear();
+}
+
+//-------------------------------------------------------------
+// Packs a caller's record into its on-disk row. Fails if the ID is
+// malformed or the ferry is not on file.
+bool SailingASM::packRow(const SailingRecord& record, SailingRow& row) {
+    char date[DATE_LEN];
+    memcpy(date, record.date, DATE_LEN);
+    date[DATE_LEN - 1] = '\0';
 
-    file.open(filename, ios::in | ios::out | ios::binary);
+    row.sailingKey = packSailingId(date);
+    int ferryId = ferryIdOf(record.ferryName);
+    if (row.sailingKey < 0 || ferryId == 0) return false;
 
-    // ensure file is open
-    if (!file) {
-        cerr << "SailingASM: File could not be reopened." << endl;
+    row.ferryId = static_cast<unsigned short>(ferryId);
+    row.onboard = clampShort(record.onboardVehicleCount);
+    row.highLaneDm = clampShort(record.highLaneRestDm);
+    row.lowLaneDm = clampShort(record.lowLaneRestDm);
+    return true;
+}
+
+//-------------------------------------------------------------
+// Unpacks an on-disk row (the ferry name comes from the ferry catalog)
+void SailingASM::unpackRow(const SailingRow& row, SailingRecord& record) {
+    memset(&record, 0, sizeof(record));
+    unpackSailingId(row.sailingKey, record.date);
+
+    Ferry ferry;
+    if (row.ferryId != 0 && FerryASM::findFerryById(row.ferryId, ferry)) {
+        memcpy(record.ferryName, ferry.ferryName, NAME_LEN);
+        record.ferryName[NAME_LEN - 1] = '\0';
     }
+    record.highLaneRestDm = row.highLaneDm;
+    record.lowLaneRestDm = row.lowLaneDm;
+    record.onboardVehicleCount = row.onboard;
 }
 
 //-------------------------------------------------------------
 // Adds a new record to end of the file
-void SailingASM::addRecord(const SailingRecord& record) {
-    file.clear();
-    // cout << "\nRecord Details in SailingASM::addRecord" << endl;
-    // cout << "Ferry:\t" << record.ferryName << endl;
-    // cout << "HRL:\t" << record.highLaneRestLength << endl;
-    // cout << "LRL:\t" << record.lowLaneRestLength << endl;
-    file.seekp(0, ios::end);
-    file.clear();
-    file.write(reinterpret_cast<const char*>(&record), sizeof(SailingRecord));
-    file.flush();
-    if (!file) {
+bool SailingASM::addRecord(const SailingRecord& record) {
+    static LatencyProbe latencyProbe("sailingASM.addRecord");
+    LatencyTimer timer(latencyProbe);
+    SailingRow row;
+    if (!packRow(record, row)) {
+        cerr << "[ERROR] Invalid sailing ID or unknown ferry in addRecord()." << endl;
+        return false;
+    }
+    if (file.lockAppend() < 0) return false;
+
+    syncIndex();
+    if (idIndex.count(row.sailingKey)) return false;
+
+    int index = file.append(row);
+    if (index < 0) {
         cerr << "[ERROR] Failed to write the record in addRecord()." << endl;
-    } else {
-        cout << "Sailing record written successfully." << endl;
+        return false;
     }
+    resizeSlots(index + 1);
+    indexSlot(index, row);
+    return true;
+}
+
+//-------------------------------------------------------------
+// Appends a batch of sailings with a single resize and copy
+bool SailingASM::addRecords(const vector<SailingRecord>& records) {
+    static LatencyProbe latencyProbe("sailingASM.addRecords");
+    LatencyTimer timer(latencyProbe);
+    if (records.empty()) return true;
+
+    vector<SailingRow> rows(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!packRow(records[i], rows[i])) {
+            cerr << "[ERROR] Invalid sailing ID or unknown ferry in addRecords()." << endl;
+            return false;
+        }
+    }
+
+    syncIndex();
+    int first = file.appendMany(rows.data(), static_cast<int>(rows.size()));
+    if (first < 0) {
+        cerr << "[ERROR] Failed to write the records in addRecords()." << endl;
+        return false;
+    }
+    resizeSlots(first + static_cast<int>(rows.size()));
+    for (size_t i = 0; i < rows.size(); ++i) {
+        indexSlot(first + static_cast<int>(i), rows[i]);
+    }
+    return true;
 }
 
 //-------------------------------------------------------------
 // Retrieves a record by index (0-based)
 // Returns true if read is successful
 bool SailingASM::getRecord(int index, SailingRecord& outRecord) {
-    int offset = index * static_cast<int>(sizeof(SailingRecord));
-    file.seekg(offset, ios::beg);
-    file.read(reinterpret_cast<char*>(&outRecord), sizeof(SailingRecord));
-    return file.good();  // Explicit boolean result
+    static LatencyProbe latencyProbe("sailingASM.getRecord");
+    LatencyTimer timer(latencyProbe);
+    SailingRow row;
+    if (!file.get(index, row)) return false;
+    unpackRow(row, outRecord);
+    return true;
 }
 
 //-------------------------------------------------------------
 // Updates an existing record at given index
-void SailingASM::updateRecord(int index, const SailingRecord& record) {
-    int offset = index * static_cast<int>(sizeof(SailingRecord));
-    file.seekp(offset, ios::beg);
-    file.write(reinterpret_cast<const char*>(&record), sizeof(SailingRecord));
+// Returns true if the record was written
+bool SailingASM::updateRecord(int index, const SailingRecord& record) {
+    static LatencyProbe latencyProbe("sailingASM.updateRecord");
+    LatencyTimer timer(latencyProbe);
+    SailingRow row;
+    if (!packRow(record, row)) {
+        cerr << "[ERROR] Invalid sailing ID or unknown ferry in updateRecord()." << endl;
+        return false;
+    }
+    if (!file.update(index, row)) {
+        cerr << "[ERROR] Failed to write the record in updateRecord()." << endl;
+        return false;
+    }
+
+    if (index < static_cast<int>(slotKeys.size())) {
+        indexSlot(index, row);
+    }
+    return true;
 }
 
 //-------------------------------------------------------------
 // Deletes record at given index using overwrite-and-truncate strategy
-void SailingASM::deleteRecord(int index) {
+bool SailingASM::deleteRecord(int index) {
+    static LatencyProbe latencyProbe("sailingASM.deleteRecord");
+    LatencyTimer timer(latencyProbe);
+    // the slot and everything after it move or go: lock before counting
+    if (!file.lockTail(index)) return false;
     int count = getRecordCount();
-    if (index < 0 || index >= count) return;
+    if (index < 0 || index >= count) return false;
+
+    syncIndex();
+    setSlotKey(index, -1);
+    setSlotFerry(index, 0);
+    setSlotRoom(index, -1, -1);
 
-    // If not last record, overwrite with last record
+    // If not last record, overwrite with last record (moved as a row:
+    // it needs no ferry lookup and keeps a row whose ferry is unknown)
     if (index != count - 1) {
-        SailingRecord last;
-        getRecord(count - 1, last);
-        updateRecord(index, last);
+        SailingRow last;
+        if (!file.get(count - 1, last) || !file.update(index, last)) {
+            cerr << "[ERROR] Failed to move the last record in deleteRecord()." << endl;
+            return false;
+        }
+        indexSlot(index, last);
     }
 
-    file.flush();
-    file.close();
-    truncateFile(count - 1);
-    file.open(filename, ios::in | ios::out | ios::binary);
+    return truncateFile(count - 1);
 }
 
 //-------------------------------------------------------------
 // Returns number of records in the file
 int SailingASM::getRecordCount() {
-    file.clear();
-    if (!file.is_open() || !file.good()) {
+    if (!file.isOpen()) {
         cout << "[ERROR] Problem in getRecordCount()." << endl;
         return 0;
     }
-    file.seekg(0, ios::end);
-    // cout << "tellg(): " << file.tellg() << endl;
-    return static_cast<int>(file.tellg() / sizeof(SailingRecord));
+    return file.size();
 }
 
 //-------------------------------------------------------------
-// Flushes the file stream to disk
+// Schedules write-back of the mapped records
 void SailingASM::flush() {
     file.flush();
 }
 
 //-------------------------------------------------------------
-// Closes the file stream
+// Closes the file
 void SailingASM::shutdown() {
     file.close();
 }
 
 //-------------------------------------------------------------
-// Truncates file to hold only numRecords (used in delete)
-void SailingASM::truncateFile(int numRecords) {
-    fstream oldFile(filename, ios::in | ios::binary);
-    fstream newFile("temp.dat", ios::out | ios::binary);
+// A mapping of a replaced file would never see its changes
+bool SailingASM::reopenIfReplaced() {
+    if (!file.isOpen() || file.isCurrentFile()) return false;
+    file.close();
+    if (!openFile()) {
+        cerr << "SailingASM Error: Could not reopen file." << endl;
+    }
+    rebuildIndex();
+    return true;
+}
 
-    SailingRecord temp;
-    for (int i = 0; i < numRecords; ++i) {
-        oldFile.read(reinterpret_cast<char*>(&temp), sizeof(SailingRecord));
-        newFile.write(reinterpret_cast<const char*>(&temp), sizeof(SailingRecord));
+//-------------------------------------------------------------
+// Looks up a sailing's record slot through the ID index
+int SailingASM::findIndexById(const char* sailingId) {
+    static LatencyProbe latencyProbe("sailingASM.findIndexById");
+    LatencyTimer timer(latencyProbe);
+    syncIndex();
+    auto it = idIndex.find(packSailingId(sailingId));
+    return (it == idIndex.end()) ? -1 : it->second;
+}
+
+//-------------------------------------------------------------
+// Index lookup, then lock, then confirm the slot still holds the ID
+int SailingASM::lockIndexById(const char* sailingId) {
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        int index = findIndexById(sailingId);
+        if (index < 0 || !file.lockRecord(index)) return -1;
+
+        SailingRow r;
+        if (file.get(index, r) && r.sailingKey == packSailingId(sailingId)) return index;
+        // moved while we waited; the next lookup sees the change
     }
+    return -1;
+}
 
-    oldFile.close();
-    newFile.close();
+//-------------------------------------------------------------
+bool SailingASM::lockAll() {
+    return file.lockTail(0);
+}
+
+//-------------------------------------------------------------
+// TTT-DD-HH -> ((TTT base 26) * 31 + DD-1) * 24 + HH-1
+int SailingASM::packSailingId(const char* sailingId) {
+    if (sailingId == nullptr || strlen(sailingId) != 9 ||
+        sailingId[3] != '-' || sailingId[6] != '-') return -1;
+
+    int key = 0;
+    for (int i = 0; i < 3; ++i) {
+        char c = sailingId[i];
+        if (c < 'A' || c > 'Z') return -1;
+        key = key * 26 + (c - 'A');
+    }
+
+    for (int i : {4, 5, 7, 8}) {
+        if (sailingId[i] < '0' || sailingId[i] > '9') return -1;
+    }
+    int day  = (sailingId[4] - '0') * 10 + (sailingId[5] - '0');
+    int hour = (sailingId[7] - '0') * 10 + (sailingId[8] - '0');
+    if (day < 1 || day > 31 || hour < 1 || hour > 24) return -1;
 
-    remove(filename);
-    rename("temp.dat", filename);
+    return (key * 31 + (day - 1)) * 24 + (hour - 1);
 }
 
 //-------------------------------------------------------------
-// Checks whether a given ferry name is used in any sailing
-std::vector<char*> SailingASM::findSailingsWithFerry(char* ferryName) {
-    vector<char*> results;
+// Inverse of packSailingId
+void SailingASM::unpackSailingId(int key, char sailingId[DATE_LEN]) {
+    memset(sailingId, 0, DATE_LEN);
+    if (key < 0 || key >= 26 * 26 * 26 * 31 * 24) return;
+
+    int hour = key % 24 + 1;
+    key /= 24;
+    int day = key % 31 + 1;
+    key /= 31;
+    snprintf(sailingId, DATE_LEN, "%c%c%c-%02d-%02d",
+             'A' + key / 676, 'A' + key / 26 % 26, 'A' + key % 26, day, hour);
+}
+
+//-------------------------------------------------------------
+// Rebuilds the ID, ferry and lane-length indexes with one pointer walk
+// over the mapping
+void SailingASM::rebuildIndex() {
+    idIndex.clear();
+    slotKeys.clear();
+    ferryIndex.clear();
+    slotFerries.clear();
+    slotHigh.clear();
+    slotLow.clear();
+    highRoom.clear();
+    lowRoom.clear();
+    seenAborts = WriteAheadLog::aborts();
+
+    ScanLock<SailingRow> scan(file);
+    file.markSynced();
+    file.size();    // pick up the current length before walking
+    for (const SailingRow* r = file.begin(); r != file.end(); ++r) {
+        int index = static_cast<int>(slotKeys.size());
+        resizeSlots(index + 1);
+        indexSlot(index, *r);
+    }
+}
+
+//-------------------------------------------------------------
+// Indexes slot `index` under the row's sailing ID, ferry and lane room
+void SailingASM::indexSlot(int index, const SailingRow& row) {
+    setSlotKey(index, row.sailingKey);
+    setSlotFerry(index, row.ferryId);
+    setSlotRoom(index, row.highLaneDm, row.lowLaneDm);
+}
+
+//-------------------------------------------------------------
+// Another handle (here or in another process) may have changed the
+// file: any change counts, as the lane-length indexes follow record
+// contents. So does an aborted transaction, whose staged updates the
+// index already reflects.
+void SailingASM::syncIndex() {
+    if (getRecordCount() != static_cast<int>(slotKeys.size()) ||
+        file.changedElsewhere(true) ||
+        WriteAheadLog::aborts() != seenAborts) {
+        rebuildIndex();
+    }
+}
+
+//-------------------------------------------------------------
+// Re-points a slot at a new key (-1 = unindexed)
+void SailingASM::setSlotKey(int index, int key) {
+    int old = slotKeys[index];
+    if (old == key) return;
+
+    if (old >= 0) {
+        auto it = idIndex.find(old);
+        if (it != idIndex.end() && it->second == index) idIndex.erase(it);
+    }
+    if (key >= 0) idIndex[key] = index;
+    slotKeys[index] = key;
+}
+
+//-------------------------------------------------------------
+// Re-points a slot at a new ferry ID (0 = unindexed)
+void SailingASM::setSlotFerry(int index, int ferry) {
+    int& old = slotFerries[index];
+    if (old == ferry) return;
 
-    ifstream sailings(filename, ios::binary);
-    if (!sailings) {
-        return results;
+    if (old != 0) {
+        auto range = ferryIndex.equal_range(old);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == index) {
+                ferryIndex.erase(it);
+                break;
+            }
+        }
+    }
+    if (ferry != 0) ferryIndex.insert(make_pair(ferry, index));
+    old = ferry;
+}
+
+//-------------------------------------------------------------
+// Re-points a slot's lane-length entries (negative = unindexed)
+void SailingASM::setSlotRoom(int index, int high, int low) {
+    RoomIndex::iterator& h = slotHigh[index];
+    if (h == highRoom.end() || h->first != high) {
+        if (h != highRoom.end()) highRoom.erase(h);
+        h = (high >= 0) ? highRoom.insert(make_pair(high, index)) : highRoom.end();
     }
 
-    SailingRecord sailing;
+    RoomIndex::iterator& l = slotLow[index];
+    if (l == lowRoom.end() || l->first != low) {
+        if (l != lowRoom.end()) lowRoom.erase(l);
+        l = (low >= 0) ? lowRoom.insert(make_pair(low, index)) : lowRoom.end();
+    }
+}
 
-    while (sailings.read(reinterpret_cast<char*>(&sailing), sizeof(SailingRecord))) {
-        if (strncmp(sailing.ferryName, ferryName, sizeof(sailing.ferryName)) == 0) {
-            char* sailingID = new char[strlen(sailing.date) + 1];
-            strcpy(sailingID, sailing.date);
-            results.push_back(sailingID);
+//-------------------------------------------------------------
+// Sizes the per-slot tables to numRecords; dropped slots leave every index
+void SailingASM::resizeSlots(int numRecords) {
+    while (static_cast<int>(slotKeys.size()) > numRecords) {
+        int last = static_cast<int>(slotKeys.size()) - 1;
+        setSlotKey(last, -1);
+        setSlotFerry(last, 0);
+        setSlotRoom(last, -1, -1);
+        slotKeys.pop_back();
+        slotFerries.pop_back();
+        slotHigh.pop_back();
+        slotLow.pop_back();
+    }
+    slotKeys.resize(numRecords, -1);
+    slotFerries.resize(numRecords, 0);
+    slotHigh.resize(numRecords, highRoom.end());
+    slotLow.resize(numRecords, lowRoom.end());
+}
+
+//-------------------------------------------------------------
+// Truncates file to hold only numRecords (used in delete)
+bool SailingASM::truncateFile(int numRecords) {
+    static LatencyProbe latencyProbe("sailingASM.truncateFile");
+    LatencyTimer timer(latencyProbe);
+    if (numRecords < 0) numRecords = 0;
+
+    resizeSlots(numRecords);
+    return file.truncate(numRecords);
+}
+
+//-------------------------------------------------------------
+// Slots of the sailings assigned to a ferry, from the ferry index
+std::vector<int> SailingASM::findSailingsWithFerry(const char* ferryName) {
+    syncIndex();
+    vector<int> slots;
+
+    int ferryId = ferryIdOf(ferryName);
+    if (ferryId == 0) return slots;
+    auto range = ferryIndex.equal_range(ferryId);
+    for (auto it = range.first; it != range.second; ++it) {
+        slots.push_back(it->second);
+    }
+    sort(slots.begin(), slots.end());
+    return slots;
+}
+
+//-------------------------------------------------------------
+// Checks whether a given ferry name is used in any sailing
+bool SailingASM::ferryInUse(const char* ferryName) {
+    syncIndex();
+    int ferryId = ferryIdOf(ferryName);
+    return ferryId != 0 && ferryIndex.find(ferryId) != ferryIndex.end();
+}
+
+//-------------------------------------------------------------
+// Range scans over the lane-length indexes. A regular vehicle's
+// candidates with low lane room come first; the high lane pass skips
+// slots already visited that way.
+int SailingASM::forEachWithRoom(float height, float length, const function<bool(int)>& visit) {
+    static LatencyProbe latencyProbe("sailingASM.forEachWithRoom");
+    LatencyTimer timer(latencyProbe);
+    syncIndex();
+    bool isTall = (height > 2.0f);
+    int needed = toDecimetres(length);
+    int visited = 0;
+
+    if (!isTall) {
+        for (auto it = lowRoom.lower_bound(needed); it != lowRoom.end(); ++it) {
+            ++visited;
+            if (!visit(it->second)) return visited;
         }
     }
 
-    return results;
+    for (auto it = highRoom.lower_bound(needed); it != highRoom.end(); ++it) {
+        if (!isTall) {
+            RoomIndex::iterator low = slotLow[it->second];
+            if (low != lowRoom.end() && low->first >= needed) continue;
+        }
+        ++visited;
+        if (!visit(it->second)) return visited;
+    }
+    return visited;
 }
@@ -4,13 +4,21 @@
 // Version: 2.0
 // Author: Wenbo Zhang
 // Purpose: Header file for SailingASM class.
-// Provides binary record-based file access for fixed-length SailingRecord.
+// Provides binary record-based file access for fixed-length sailing
+// records. On disk a sailing is a packed 12-byte SailingRow (format
+// v2); callers see the unpacked SailingRecord.
 //***************************************************
 
 #ifndef SAILING_ASM_H
 #define SAILING_ASM_H
 
-#include <fstream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <functional>
+#include <cmath>
+#include "recordFile.h"
 
 //--------------------------------------
 // Constants for record field lengths
@@ -18,29 +26,65 @@ const int DATE_LEN = 10;   // "TTT-DD-HH" + '\0' = 9 + 1
 const int NAME_LEN = 26;   // Ferry name: varchar(1–25) + null
 
 //--------------------------------------
-// SailingRecord structure
+// Lane lengths are kept in whole decimetres so that taking and giving
+// back a vehicle's length is exact (vehicle sizes have one decimal).
+inline int toDecimetres(float metres) { return static_cast<int>(std::lround(metres * 10.0f)); }
+inline float toMetres(int decimetres) { return decimetres / 10.0f; }
+
+//--------------------------------------
+// SailingRecord structure (as seen by callers)
 struct SailingRecord {
     char date[DATE_LEN];              // Primary key: e.g., "ABC-17-08"
     char ferryName[NAME_LEN];         // Ferry name (max 25 chars)
-    float highLaneRestLength;         // Remaining high lane length
-    float lowLaneRestLength;          // Remaining low lane length
+    int highLaneRestDm;               // Remaining high lane length, decimetres
+    int lowLaneRestDm;                // Remaining low lane length, decimetres
     int onboardVehicleCount;          // Vehicles marked as onboard
 };
 
+//--------------------------------------
+// SailingRow structure (as stored in sailings.dat)
+struct SailingRow {
+    int sailingKey;                   // packSailingId() of the sailing ID
+    unsigned short ferryId;           // Ferry::ferryId in ferries.dat
+    unsigned short onboard;           // Vehicles marked as onboard
+    unsigned short highLaneDm;        // Remaining high lane length, decimetres (ferry max 3600 m)
+    unsigned short lowLaneDm;         // Remaining low lane length, decimetres
+};
+
 //--------------------------------------
 // Binary file access class
 class SailingASM {
 private:
-    std::fstream file;
+    RecordFile<SailingRow> file;
     const char* filename = "sailings.dat";
 
+    // Packed sailing ID -> record slot, plus the reverse (slot -> key) so
+    // updates and swap-with-last deletes can fix the map without re-reading.
+    std::unordered_map<int, int> idIndex;
+    std::vector<int> slotKeys;
+
+    // Ferry ID -> slots of the sailings it is assigned to, with the
+    // slot -> ferry ID reverse kept the same way as slotKeys.
+    std::unordered_multimap<int, int> ferryIndex;
+    std::vector<int> slotFerries;
+    // Remaining lane length (decimetres) -> slot, one ordered index per
+    // lane class, with each slot's entry kept so an update is one
+    // erase + insert.
+    typedef std::multimap<int, int> RoomIndex;
+    RoomIndex highRoom;
+    RoomIndex lowRoom;
+    std::vector<RoomIndex::iterator> slotHigh;
+    std::vector<RoomIndex::iterator> slotLow;
+    unsigned long seenAborts = 0;           // WriteAheadLog::aborts() at last rebuild
+
 public:
     //--------------------------------------
-    // Initializes file stream for read/write access
-    void initialize();
+    // Opens (creating if needed) and maps the sailing file; false if it
+    // could not be opened
+    bool initialize();
 
     //--------------------------------------
-    // Closes file stream
+    // Unmaps and closes the sailing file
     void shutdown();
 
     //--------------------------------------
@@ -48,14 +92,29 @@ public:
     void reset();
 
     //--------------------------------------
-    // Forces file buffer to flush
+    // Schedules write-back of changed records
     void flush();
 
     //--------------------------------------
-    // Adds a new sailing record
+    // Reopens and re-indexes the file if its path was renamed over
+    // since it was opened (StoreRegistry::revalidate)
+    // Returns: true if the file was reopened
+    bool reopenIfReplaced();
+
+    //--------------------------------------
+    // Adds a new sailing record. The ID is checked again while the end
+    // of the file is locked, so two booths cannot add the same sailing.
     // Parameters:
     //   in  record - sailing information to write
-    void addRecord(const SailingRecord& record);
+    // Returns: true if the record was written, false if the ID exists
+    bool addRecord(const SailingRecord& record);
+
+    //--------------------------------------
+    // Appends many sailing records in one write (bulk import)
+    // Parameters:
+    //   in  records - sailings to add; IDs must be new
+    // Returns: true if all were written
+    bool addRecords(const std::vector<SailingRecord>& records);
 
     //--------------------------------------
     // Reads a sailing record by index
@@ -70,32 +129,112 @@ public:
     // Parameters:
     //   in index   - position in file to update
     //   in record  - updated sailing info
-    void updateRecord(int index, const SailingRecord& record);
+    // Returns: true if written (false for an unknown ferry or a failed write)
+    bool updateRecord(int index, const SailingRecord& record);
 
     //--------------------------------------
     // Deletes record by index using overwrite strategy
     // Parameters:
     //   in index - index of record to delete
-    void deleteRecord(int index);
+    // Returns: false if the slot is out of range or a write failed
+    bool deleteRecord(int index);
+
+    //--------------------------------------
+    // True if opening the file converted it from format v1
+    bool wasMigrated() const;
 
     //--------------------------------------
     // Returns total number of sailing records in file
     int getRecordCount();
 
     //--------------------------------------
-    // Searches if a ferry name is present in any record
-    // and returns the IDs for the sailings that the ferry is assigned to
+    // Looks up the record slot of a sailing by ID
+    // Parameters:
+    //   in sailingId - sailing ID (format: TTT-DD-HH)
+    // Returns: zero-based index, or -1 if not found
+    int findIndexById(const char* sailingId);
+
+    //--------------------------------------
+    // Looks up a sailing and locks its record for update until the
+    // operation commits (see recordFile.h). The slot is re-checked
+    // under the lock, as another process may have moved the record.
+    // Parameters:
+    //   in sailingId - sailing ID (format: TTT-DD-HH)
+    // Returns: zero-based index, or -1 if not found
+    int lockIndexById(const char* sailingId);
+
+    //--------------------------------------
+    // Locks the whole sailing file until the operation commits
+    // (bulk import and the start-up onboard recount)
+    // Returns: true if the lock is held
+    bool lockAll();
+
+    //--------------------------------------
+    // Encodes a TTT-DD-HH sailing ID into a compact integer key
+    // (26^3 terminals x 31 days x 24 hours fits comfortably in an int)
+    // Parameters:
+    //   in sailingId - sailing ID, already normalized by isValidSailingId
+    // Returns: key >= 0, or -1 if the ID is malformed
+    static int packSailingId(const char* sailingId);
+
+    //--------------------------------------
+    // Decodes a key from packSailingId back into TTT-DD-HH
+    // Parameters:
+    //   in  key       - packed sailing ID
+    //   out sailingId - the ID ("" if the key is out of range)
+    static void unpackSailingId(int key, char sailingId[DATE_LEN]);
+
+    //--------------------------------------
+    // Looks up the sailings a ferry is assigned to through the ferry index
     // Parameters:
     //   in ferryName - name of ferry to search for
-    // Returns: true if found
-    std::vector<char*> findSailingsWithFerry(char* ferryName);
+    // Returns: record slots of those sailings, in file order (empty if none)
+    std::vector<int> findSailingsWithFerry(const char* ferryName);
+
+    //--------------------------------------
+    // Checks whether any sailing uses the ferry (one hash lookup)
+    // Parameters:
+    //   in ferryName - name of ferry to check
+    // Returns: true if at least one sailing is assigned to it
+    bool ferryInUse(const char* ferryName);
+
+    //--------------------------------------
+    // Streams the slots of sailings with room for a vehicle, through
+    // the lane-length indexes (O(log n + k)). Tall vehicles (> 2.0 m)
+    // need high lane room; others fit in either lane.
+    // Parameters:
+    //   in height - vehicle height, metres
+    //   in length - vehicle length (lane metres needed)
+    //   in visit  - called with each slot; return false to stop
+    // Returns: number of slots visited
+    int forEachWithRoom(float height, float length, const std::function<bool(int)>& visit);
 
 private:
+    //--------------------------------------
+    // Migrates a format v1 file, then opens the file
+    bool openFile();
+    bool migrated = false;                  // openFile() converted a v1 file
+
+    //--------------------------------------
+    // Record <-> row conversion (ferry name <-> ferry ID via FerryASM)
+    static bool packRow(const SailingRecord& record, SailingRow& row);
+    static void unpackRow(const SailingRow& row, SailingRecord& record);
+
     //--------------------------------------
     // Truncates file to hold only numRecords
     // Parameters:
     //   in numRecords - number of records to retain
-    void truncateFile(int numRecords);
+    bool truncateFile(int numRecords);
+
+    //--------------------------------------
+    // Index maintenance helpers
+    void rebuildIndex();                     // Full scan to repopulate the indexes
+    void syncIndex();                        // Rebuild if another handle changed the file
+    void setSlotKey(int index, int key);     // Point slot at key (updates both maps)
+    void setSlotFerry(int index, int ferryId);              // Same for the ferry index (0 = none)
+    void setSlotRoom(int index, int high, int low);         // Same for the lane-length indexes (< 0 = none)
+    void indexSlot(int index, const SailingRow& row);       // All of the above from a row
+    void resizeSlots(int numRecords);       // Grow (unindexed) or shrink (unindexing) the slot tables
 };
 
 #endif
@@ -0,0 +1,86 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: storeRegistry.cpp
+// Purpose:
+//   Owns the process-wide ASM handles (function statics, so they exist
+//   before any manager that refers to them is constructed).
+//***************************************************
+
+#include "storeRegistry.h"
+
+namespace {
+    bool opened = false;
+    bool recovered = false;     // files changed at start-up (replay or migration)
+}
+
+//--------------------------------------
+SailingASM& StoreRegistry::sailings() {
+    static SailingASM handle;
+    return handle;
+}
+
+//--------------------------------------
+ReservationASM& StoreRegistry::reservations() {
+    static ReservationASM handle;
+    return handle;
+}
+
+//--------------------------------------
+VehicleASM& StoreRegistry::vehicles() {
+    static VehicleASM handle;
+    return handle;
+}
+
+//--------------------------------------
+bool StoreRegistry::openAll() {
+    if (opened) return true;
+    bool ok = FerryASM::initialize() &&
+              vehicles().initialize() &&
+              sailings().initialize() &&
+              reservations().initialize();
+    opened = true;
+    if (!ok) {
+        closeAll();
+        return false;
+    }
+    if (sailings().wasMigrated() || reservations().wasMigrated()) recovered = true;
+    return true;
+}
+
+//--------------------------------------
+void StoreRegistry::closeAll() {
+    if (!opened) return;
+    reservations().shutdown();
+    sailings().shutdown();
+    vehicles().shutdown();
+    FerryASM::shutdown();
+    opened = false;
+}
+
+//--------------------------------------
+int StoreRegistry::revalidate() {
+    if (!opened) return 0;
+    int reopened = 0;
+    if (FerryASM::reopenIfReplaced()) ++reopened;
+    if (vehicles().reopenIfReplaced()) ++reopened;
+    if (sailings().reopenIfReplaced()) ++reopened;
+    if (reservations().reopenIfReplaced()) ++reopened;
+    return reopened;
+}
+
+//--------------------------------------
+bool StoreRegistry::isOpen() {
+    return opened;
+}
+
+//--------------------------------------
+void StoreRegistry::noteRecovery() {
+    recovered = true;
+}
+
+//--------------------------------------
+bool StoreRegistry::takeRecovery() {
+    bool was = recovered;
+    recovered = false;
+    return was;
+}
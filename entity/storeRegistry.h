@@ -0,0 +1,65 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: storeRegistry.h
+// Purpose:
+//   The one handle per data file of the process. SailingManager,
+//   ReservationService, the importer, the server and the benchmark all
+//   work on these ASMs instead of opening their own, so each file is
+//   opened, mapped and indexed once, by start(), and closed once, by
+//   shutdown(). (Ferries already live in FerryASM's statics; the
+//   registry only opens and closes them in order.)
+//
+//   Changes made by other processes need no reopen: each ASM compares
+//   its file's shared change counters (<file>.gen) on use and rebuilds
+//   its index when they moved. The one case the counters miss is a
+//   file renamed over on disk, which the mapping never sees;
+//   revalidate() reopens those, and is called between menu actions and
+//   by the server every poll interval.
+//***************************************************
+
+#ifndef STORE_REGISTRY_H
+#define STORE_REGISTRY_H
+
+#include "ferryASM.h"
+#include "sailingASM.h"
+#include "reservationASM.h"
+#include "vehicleASM.h"
+
+class StoreRegistry {
+public:
+    //--------------------------------------
+    // The process-wide handles. Valid (but closed) before openAll().
+    static SailingASM& sailings();
+    static ReservationASM& reservations();
+    static VehicleASM& vehicles();
+
+    //--------------------------------------
+    // Opens every data file that is not open yet, ferries first (sailing
+    // rows refer to ferry IDs), then vehicles, sailings, reservations.
+    // Stops at the first that fails to open, closes the others again and
+    // returns false.
+    static bool openAll();
+
+    //--------------------------------------
+    // Closes every data file (the handles can be opened again)
+    static void closeAll();
+
+    //--------------------------------------
+    // Reopens any data file renamed over since it was opened
+    // Returns: number of files reopened
+    static int revalidate();
+
+    //--------------------------------------
+    // True between openAll() and closeAll()
+    static bool isOpen();
+
+    //--------------------------------------
+    // Records that the data files were changed behind any counters kept
+    // in them: a write-ahead log replay (noted by start()) or a format
+    // migration of sailings or reservations (noted by openAll()).
+    // takeRecovery() reports it once and clears it.
+    static void noteRecovery();
+    static bool takeRecovery();
+};
+
+#endif // STORE_REGISTRY_H
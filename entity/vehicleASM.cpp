@@ -10,117 +10,172 @@
 //***************************************************
 
 #include "vehicleASM.h"
+#include "../system/latencyStats.h"
 #include <iostream>
 #include <cstdio>
 #include <cstring>
 
 using namespace std;
 
+#define FILE_KIND "VEHI"
+
 //--------------------------------------
-// Initialize file stream for read/write
-void VehicleASM::initialize() {
-    file.open(filename, ios::in | ios::out | ios::binary);
-    if (!file) {
-        file.clear();
-        file.open(filename, ios::out | ios::binary); // create empty file
-        file.close();
-        file.open(filename, ios::in | ios::out | ios::binary);
-    }
-    if (!file.good()) {
+// The Vehicle record itself is unchanged in format v2; a v1 file only
+// gains the header
+bool VehicleASM::openFile() {
+    migrateRecordFile<Vehicle, Vehicle>(filename, FILE_KIND, [](const Vehicle& old, Vehicle& vehicle) {
+        vehicle = old;
+        return true;
+    });
+    return file.open(filename, FILE_KIND);
+}
+
+//--------------------------------------
+// Open (or create) and map the vehicle file
+bool VehicleASM::initialize() {
+    bool opened = openFile();
+    if (!opened) {
         cerr << "VehicleASM Error: Could not open file." << endl;
     }
+    rebuildIndex();
+    return opened;
 }
 
 void VehicleASM::reset() {
-    if (file.is_open()) file.close();
-
-    ofstream resetFile(filename, ios::out | ios::trunc | ios::binary);
-    
-    if (resetFile.is_open()) resetFile.close();
-    else {
+    if (!file.isOpen() && !openFile()) {
         cerr << "Could not reset the Vehicle file." << endl;
         return;
     }
-
-    file.open(filename, ios::in | ios::out | ios::binary);
-
-    if (!file) {
-        cerr << "VehicleASM: File could not be reopened." << endl;
+    if (!file.reset()) {
+        cerr << "Could not reset the Vehicle file." << endl;
     }
+
+    plateIndex.clear();
+    indexedCount = 0;
 }
 
 //--------------------------------------
 // Add a vehicle record to end of file
-void VehicleASM::addRecord(const Vehicle& record) {
-    file.seekp(0, ios::end);
-    file.write(reinterpret_cast<const char*>(&record), sizeof(Vehicle));
+bool VehicleASM::addRecord(const Vehicle& record) {
+    static LatencyProbe latencyProbe("vehicleASM.addRecord");
+    LatencyTimer timer(latencyProbe);
+    syncIndex();
+    int index = file.append(record);
+    if (index < 0) return false;
+
+    plateIndex[record.licensePlate] = index;
+    indexedCount = index + 1;
+    return true;
+}
+
+//--------------------------------------
+// Append a batch of vehicles with a single resize and copy
+bool VehicleASM::addRecords(const std::vector<Vehicle>& records) {
+    static LatencyProbe latencyProbe("vehicleASM.addRecords");
+    LatencyTimer timer(latencyProbe);
+    if (records.empty()) return true;
+    syncIndex();
+    int first = file.appendMany(records.data(), static_cast<int>(records.size()));
+    if (first < 0) return false;
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        plateIndex[records[i].licensePlate] = first + static_cast<int>(i);
+    }
+    indexedCount = first + static_cast<int>(records.size());
+    return true;
 }
 
 //--------------------------------------
 // Get a vehicle record by index
 bool VehicleASM::getRecord(int index, Vehicle& outRecord) {
-    int offset = index * sizeof(Vehicle);
-    file.seekg(offset, ios::beg);
-    file.read(reinterpret_cast<char*>(&outRecord), sizeof(Vehicle));
-    return file.good();
+    static LatencyProbe latencyProbe("vehicleASM.getRecord");
+    LatencyTimer timer(latencyProbe);
+    return file.get(index, outRecord);
 }
 
 //--------------------------------------
 // Update a vehicle record by index
-void VehicleASM::updateRecord(int index, const Vehicle& record) {
-    int offset = index * sizeof(Vehicle);
-    file.seekp(offset, ios::beg);
-    file.write(reinterpret_cast<const char*>(&record), sizeof(Vehicle));
+bool VehicleASM::updateRecord(int index, const Vehicle& record) {
+    static LatencyProbe latencyProbe("vehicleASM.updateRecord");
+    LatencyTimer timer(latencyProbe);
+    Vehicle old;
+    bool hadOld = index < indexedCount && getRecord(index, old);
+
+    if (!file.update(index, record)) {
+        cerr << "[ERROR] Failed to update vehicle record " << index << "." << endl;
+        return false;
+    }
+
+    // the index follows only once the record is written
+    if (hadOld && strcmp(old.licensePlate, record.licensePlate) != 0) {
+        auto it = plateIndex.find(old.licensePlate);
+        if (it != plateIndex.end() && it->second == index) plateIndex.erase(it);
+    }
+    if (index < indexedCount) plateIndex[record.licensePlate] = index;
+    return true;
 }
 
 //--------------------------------------
 // Delete a vehicle record by index
-void VehicleASM::deleteRecord(int index) {
+bool VehicleASM::deleteRecord(int index) {
+    static LatencyProbe latencyProbe("vehicleASM.deleteRecord");
+    LatencyTimer timer(latencyProbe);
+    // the slot and everything after it move or go: lock before counting
+    if (!file.lockTail(index)) return false;
     int count = getRecordCount();
-    if (index < 0 || index >= count) return;
+    if (index < 0 || index >= count) return false;
+
+    syncIndex();
+    Vehicle removed;
+    if (getRecord(index, removed)) plateIndex.erase(removed.licensePlate);
 
     if (index != count - 1) {
         Vehicle last;
-        getRecord(count - 1, last);
-        updateRecord(index, last);
+        if (!getRecord(count - 1, last) || !updateRecord(index, last)) {
+            cerr << "[ERROR] Failed to move the last record in deleteRecord()." << endl;
+            return false;
+        }
     }
 
-    file.flush();
-    file.close();
-    truncateFile(count - 1);
-    file.open(filename, ios::in | ios::out | ios::binary);
+    return truncateFile(count - 1);
 }
 
 //--------------------------------------
 // Get total number of vehicle records
 int VehicleASM::getRecordCount() {
-    file.seekg(0, ios::end);
-    return file.tellg() / sizeof(Vehicle);
+    return file.size();
 }
 
 //--------------------------------------
-// Force flush to disk
+// Schedule write-back of changed records
 void VehicleASM::flush() {
     file.flush();
 }
 
 //--------------------------------------
-// Close the file stream
+// Unmap and close the file
 void VehicleASM::shutdown() {
     file.close();
 }
 
+//--------------------------------------
+// A mapping of a replaced file would never see its changes
+bool VehicleASM::reopenIfReplaced() {
+    if (!file.isOpen() || file.isCurrentFile()) return false;
+    file.close();
+    if (!openFile()) {
+        cerr << "VehicleASM Error: Could not reopen file." << endl;
+    }
+    rebuildIndex();
+    return true;
+}
+
 //--------------------------------------
 // Search for vehicle by license plate
 Vehicle VehicleASM::getVehicleRecord(const char licensePlate[11]) {
-    int count = getRecordCount();
     Vehicle v;
-
-    for (int i = 0; i < count; ++i) {
-        getRecord(i, v);
-        if (strcmp(v.licensePlate, licensePlate) == 0) {
-            return v;
-        }
+    if (findByPlate(licensePlate, v) >= 0) {
+        return v;
     }
 
     Vehicle empty = {};
@@ -129,20 +184,107 @@ Vehicle VehicleASM::getVehicleRecord(const char licensePlate[11]) {
 }
 
 //--------------------------------------
-// Truncate file to specified number of records
-void VehicleASM::truncateFile(int numRecords) {
-    fstream oldFile(filename, ios::in | ios::binary);
-    fstream newFile("temp.dat", ios::out | ios::binary);
+// Truncate file to specified number of records (in place)
+bool VehicleASM::truncateFile(int numRecords) {
+    static LatencyProbe latencyProbe("vehicleASM.truncateFile");
+    LatencyTimer timer(latencyProbe);
+    if (numRecords < 0) numRecords = 0;
+
+    for (int i = numRecords; i < indexedCount; ++i) {
+        Vehicle tail;
+        if (!getRecord(i, tail)) break;
+        auto it = plateIndex.find(tail.licensePlate);
+        if (it != plateIndex.end() && it->second == i) plateIndex.erase(it);
+    }
+    if (indexedCount > numRecords) indexedCount = numRecords;
+
+    return file.truncate(numRecords);
+}
+
+//--------------------------------------
+// Rebuild plate index with one pointer walk over the mapping
+void VehicleASM::rebuildIndex() {
+    plateIndex.clear();
+    indexedCount = 0;
+
+    ScanLock<Vehicle> scan(file);
+    file.markSynced();
+    file.size();    // pick up the current length before walking
+    for (const Vehicle* v = file.begin(); v != file.end(); ++v) {
+        char plate[sizeof(v->licensePlate)];
+        memcpy(plate, v->licensePlate, sizeof(plate));
+        plate[sizeof(plate) - 1] = '\0';
+        plateIndex[plate] = indexedCount++;
+    }
+}
+
+//--------------------------------------
+// Another handle (here or in another process) may have added, moved
+// or deleted records
+void VehicleASM::syncIndex() {
+    if (getRecordCount() != indexedCount || file.changedElsewhere(false)) {
+        rebuildIndex();
+    }
+}
+
+//--------------------------------------
+// Indexed lookup by license plate
+int VehicleASM::findByPlate(const char* licensePlate, Vehicle& outRecord) {
+    static LatencyProbe latencyProbe("vehicleASM.findByPlate");
+    LatencyTimer timer(latencyProbe);
+    syncIndex();
+    auto it = plateIndex.find(licensePlate);
+    if (it == plateIndex.end()) return -1;
+    if (!getRecord(it->second, outRecord)) return -1;
+    return it->second;
+}
 
-    Vehicle temp;
-    for (int i = 0; i < numRecords; ++i) {
-        oldFile.read(reinterpret_cast<char*>(&temp), sizeof(Vehicle));
-        newFile.write(reinterpret_cast<const char*>(&temp), sizeof(Vehicle));
+//--------------------------------------
+// Phone and size must match what is already on file
+bool VehicleASM::isConsistent(const Vehicle& existing, const Vehicle& incoming, std::string& errMsg) {
+    if (strcmp(existing.customerPhone, incoming.customerPhone) != 0) {
+        errMsg = "\nPhone number mismatch for plate " + std::string(incoming.licensePlate);
+        return false;
+    }
+    if (existing.specialHeight != incoming.specialHeight ||
+        existing.specialLength != incoming.specialLength) {
+        errMsg = "\nVehicle size mismatch for plate " + std::string(incoming.licensePlate);
+        return false;
     }
+    return true;
+}
+
+//--------------------------------------
+// Check-and-insert with one lookup
+VehicleUpsert VehicleASM::upsertIfConsistent(const Vehicle& record, bool& inserted, std::string& errMsg) {
+    static LatencyProbe latencyProbe("vehicleASM.upsertIfConsistent");
+    LatencyTimer timer(latencyProbe);
+    inserted = false;
 
-    oldFile.close();
-    newFile.close();
+    Vehicle existing;
+    if (findByPlate(record.licensePlate, existing) >= 0) {
+        return isConsistent(existing, record, errMsg) ? VehicleUpsert::OK : VehicleUpsert::MISMATCH;
+    }
 
-    remove(filename);
-    rename("temp.dat", filename);
+    // new plate: ask again once no other booth can append
+    if (file.lockAppend() < 0) {
+        errMsg = "\nFailed to lock the vehicle file for plate " + std::string(record.licensePlate);
+        return VehicleUpsert::STORAGE_ERROR;
+    }
+    if (findByPlate(record.licensePlate, existing) >= 0) {
+        return isConsistent(existing, record, errMsg) ? VehicleUpsert::OK : VehicleUpsert::MISMATCH;
+    }
+
+    if (!addRecord(record)) {
+        errMsg = "\nFailed to save vehicle record for plate " + std::string(record.licensePlate);
+        return VehicleUpsert::STORAGE_ERROR;
+    }
+    inserted = true;
+    return VehicleUpsert::OK;
+}
+
+//--------------------------------------
+// Whole-file lock for bulk writes
+bool VehicleASM::lockAll() {
+    return file.lockTail(0);
 }
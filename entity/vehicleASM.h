@@ -12,7 +12,10 @@
 #ifndef VEHICLE_ASM_H
 #define VEHICLE_ASM_H
 
-#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "recordFile.h"
 
 //---------------------------------------------
 // Vehicle record structure (fixed length)
@@ -23,19 +26,31 @@ struct Vehicle {
     float specialHeight;       // Vehicle height in meters (up to 1 decimal)
 };
 
+//---------------------------------------------
+// Outcome of VehicleASM::upsertIfConsistent()
+enum class VehicleUpsert {
+    OK,             // the vehicle is on file and matches
+    MISMATCH,       // the plate is on file with another phone or size
+    STORAGE_ERROR   // the file could not be locked or written
+};
+
 //---------------------------------------------
 // VehicleASM class: manages binary file I/O for Vehicle
 class VehicleASM {
 private:
     const char* filename = "vehicles.dat";  // Binary file path
-    std::fstream file;                      // File stream
+    RecordFile<Vehicle> file;               // Mapped record array
+
+    // License plate -> record index (plates are unique in vehicles.dat)
+    std::unordered_map<std::string, int> plateIndex;
+    int indexedCount = 0;                   // records covered by plateIndex
 
 public:
     //---------------------------------------------
-    // Initialize file stream for read/write access
+    // Open (creating if needed) and map the vehicle file
     // @param (none)
-    // @return (none)
-    void initialize();
+    // @return false if the file could not be opened
+    bool initialize();
 
     //---------------------------------------------
     // Clears all the data in the Vehicle file
@@ -46,8 +61,14 @@ public:
     //---------------------------------------------
     // Add a new vehicle record to end of file
     // @param in: record - vehicle data to write
-    // @return (none)
-    void addRecord(const Vehicle& record);
+    // @return true if written
+    bool addRecord(const Vehicle& record);
+
+    //---------------------------------------------
+    // Append many vehicle records in one write (bulk import)
+    // @param in: records - vehicles to add; plates must be new
+    // @return true if all were written
+    bool addRecords(const std::vector<Vehicle>& records);
 
     //---------------------------------------------
     // Get a vehicle record by index
@@ -60,14 +81,14 @@ public:
     // Update vehicle record at index
     // @param in: index - record index to update
     // @param in: record - updated vehicle data
-    // @return (none)
-    void updateRecord(int index, const Vehicle& record);
+    // @return true if the record was written
+    bool updateRecord(int index, const Vehicle& record);
 
     //---------------------------------------------
     // Delete record at index by overwrite-and-truncate
     // @param in: index - index of record to delete
-    // @return (none)
-    void deleteRecord(int index);
+    // @return true if the record was removed
+    bool deleteRecord(int index);
 
     //---------------------------------------------
     // Get total number of records
@@ -76,29 +97,81 @@ public:
     int getRecordCount();
 
     //---------------------------------------------
-    // Force flush to disk
+    // Schedule write-back of changed records
     // @param (none)
     // @return (none)
     void flush();
 
     //---------------------------------------------
-    // Close the file stream
+    // Unmap and close the file
     // @param (none)
     // @return (none)
     void shutdown();
 
+    //---------------------------------------------
+    // Reopen and re-index the file if its path was renamed over since
+    // it was opened (StoreRegistry::revalidate)
+    // @return true if the file was reopened
+    bool reopenIfReplaced();
+
     //---------------------------------------------
     // Retrieve a vehicle by license plate
     // @param in: licensePlate - plate to search
     // @return matching Vehicle record, or empty struct if not found
     Vehicle getVehicleRecord(const char licensePlate[11]);
 
+    //---------------------------------------------
+    // Indexed lookup of a vehicle by license plate
+    // @param in: licensePlate - plate to search
+    // @param out: outRecord - filled with vehicle data when found
+    // @return record index, or -1 if not found
+    int findByPlate(const char* licensePlate, Vehicle& outRecord);
+
+    //---------------------------------------------
+    // Consistency check + insert with a single index lookup:
+    // a new plate is appended, an existing plate must carry the
+    // same phone and size or the call fails. A new plate is looked
+    // up again with the end of the file locked, so two booths
+    // registering the same plate end up with one record.
+    // @param in: record - vehicle data for the booking
+    // @param out: inserted - true if a new record was written
+    // @param out: errMsg - reason when the call fails
+    // @return OK if the vehicle is now on file and consistent,
+    //         MISMATCH if the plate conflicts, STORAGE_ERROR if the
+    //         file could not be locked or written
+    VehicleUpsert upsertIfConsistent(const Vehicle& record, bool& inserted, std::string& errMsg);
+
+    //---------------------------------------------
+    // Compares a stored vehicle against booking data
+    // @param in: existing - record already on file
+    // @param in: incoming - vehicle data being booked
+    // @param out: errMsg - reason when they differ
+    // @return true if phone and size match
+    static bool isConsistent(const Vehicle& existing, const Vehicle& incoming, std::string& errMsg);
+
+    //---------------------------------------------
+    // Lock the whole vehicle file until the operation commits
+    // (bulk import; see recordFile.h)
+    // @param (none)
+    // @return true if the lock is held
+    bool lockAll();
+
 private:
+    //---------------------------------------------
+    // Adds the format v2 header to a v1 file, then opens it
+    // @return true if the file is open
+    bool openFile();
+
     //---------------------------------------------
     // Helper to truncate the binary file to n records
     // @param in: numRecords - number of records to keep
-    // @return (none)
-    void truncateFile(int numRecords);
+    // @return true if the file was resized
+    bool truncateFile(int numRecords);
+
+    //---------------------------------------------
+    // Index maintenance helpers
+    void rebuildIndex();    // Full scan to repopulate plateIndex
+    void syncIndex();       // Rebuild if another handle moved records
 };
 
 #endif // VEHICLE_ASM_H
@@ -8,8 +8,11 @@
 //***************************************************
 
 #include "ui/mainMenu.h"
+#include "ui/boothClient.h"
 #include "system/utilities.h"
 #include "control/ferryManager.h"
+#include "control/importManager.h"
+#include "control/reservationServer.h"
 #include "control/reservationManager.h"
 #include "control/sailingManager.h"
 #include "entity/ferryASM.h"
@@ -18,20 +21,39 @@
 #include "entity/vehicleASM.h"
 
 #include <iostream>
+#include <cstring>
 using namespace std;
 
 //--------------------------------------
 // Function: main
 // Purpose : Entry point for entire system execution.
-// in  : None
+// in  : argc/argv - no arguments (or --stats-file PATH) for the
+//                   interactive menu; "import ..." runs a bulk import
+//                   instead, "serve ..." the reservation server and
+//                   "client ..." a booth client of it
 // out : int - exit code (0 = success)
 //--------------------------------------
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "import") == 0) {
+        return runImport(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        return runServe(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "client") == 0) {
+        return runClient(argc, argv);
+    }
+    if (argc > 2 && strcmp(argv[1], "--stats-file") == 0) {
+        setStatsFile(argv[2]);
+    }
+
     //============================
     //  System Startup
     //============================
     //initialize();   // Load config/data from disk
-    start();        // Initialize memory, prepare state
+    if (!start()) { // Initialize memory, prepare state
+        return 1;
+    }
 
     //============================
     //  Main Menu Loop
@@ -46,7 +68,7 @@ int main() {
     //  Graceful Exit
     //============================
     // backUp();      // Save data to disk
-    // shutDown();    // Release resources, close files
+    shutdown();       // Release resources, close files (no-op if the menu already did)
 
     return 0;
 }
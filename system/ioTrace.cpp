@@ -0,0 +1,130 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// ioTrace.cpp
+// Purpose: Per-thread flow totals and the CSV writer. A flow's totals
+// live with its thread until the flow ends; only then (and for I/O
+// outside flows) is the shared trace file touched, under one mutex.
+//***************************************************
+
+#include "ioTrace.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+using namespace std;
+
+bool IoTrace::on = false;
+
+namespace {
+    struct Totals {
+        unsigned long long calls;
+        unsigned long long syscalls;
+        unsigned long long bytes;
+    };
+    typedef map<pair<string, int>, Totals> FlowTotals;     // (file, op) -> totals
+
+    struct FlowState {
+        const char* name;
+        int depth;
+        FlowTotals totals;
+    };
+
+    const char* const OP_NAMES[] = {
+        "read", "cache_read", "write", "scan", "open", "stat",
+        "map", "resize", "lock", "sys_read", "sys_write", "sync"
+    };
+
+    mutex guard;
+    ofstream trace;
+    unsigned long long flowSeq = 0;
+    FlowTotals outside;                 // I/O of no flow (guard held)
+    thread_local FlowState flow = { nullptr, 0, FlowTotals() };
+
+    string baseName(const string& path) {
+        size_t slash = path.find_last_of('/');
+        return slash == string::npos ? path : path.substr(slash + 1);
+    }
+
+    void count(FlowTotals& totals, IoOp op, const string& file, long long bytes) {
+        Totals& t = totals[make_pair(baseName(file), static_cast<int>(op))];
+        ++t.calls;
+        if (op >= IoOp::OPEN) ++t.syscalls;
+        if (bytes > 0) t.bytes += static_cast<unsigned long long>(bytes);
+    }
+
+    // (guard held)
+    void writeFlow(const char* name, const FlowTotals& totals) {
+        if (!trace.is_open() || totals.empty()) return;
+        ++flowSeq;
+        for (const auto& row : totals) {
+            trace << flowSeq << ',' << name << ',' << row.first.first << ','
+                  << OP_NAMES[row.first.second] << ',' << row.second.calls << ','
+                  << row.second.syscalls << ',' << row.second.bytes << '\n';
+        }
+        trace.flush();
+    }
+}
+
+//--------------------------------------
+bool IoTrace::open(const char* path) {
+    lock_guard<mutex> lock(guard);
+    if (trace.is_open()) trace.close();
+    trace.open(path, ios::out | ios::trunc);
+    if (!trace) {
+        cerr << "[WARN] Could not open I/O trace " << path << "; tracing is off." << endl;
+        on = false;
+        return false;
+    }
+    trace << "flow_seq,flow,file,op,calls,syscalls,bytes\n";
+    flowSeq = 0;
+    outside.clear();
+    on = true;
+    return true;
+}
+
+//--------------------------------------
+void IoTrace::configureFromEnv() {
+    const char* path = getenv("SUPERFERRY_IO_TRACE");
+    if (path != nullptr && *path != '\0') open(path);
+}
+
+//--------------------------------------
+void IoTrace::close() {
+    lock_guard<mutex> lock(guard);
+    if (!trace.is_open()) return;
+    writeFlow("-", outside);
+    outside.clear();
+    trace.close();
+    on = false;
+}
+
+//--------------------------------------
+void IoTrace::add(IoOp op, const string& file, long long bytes) {
+    if (flow.depth > 0) {
+        count(flow.totals, op, file, bytes);
+        return;
+    }
+    lock_guard<mutex> lock(guard);
+    count(outside, op, file, bytes);
+}
+
+//--------------------------------------
+IoFlow::IoFlow(const char* name) : outermost(flow.depth == 0) {
+    if (outermost) flow.name = name;
+    ++flow.depth;
+}
+
+//--------------------------------------
+IoFlow::~IoFlow() {
+    --flow.depth;
+    if (!outermost) return;
+    if (IoTrace::active() && !flow.totals.empty()) {
+        lock_guard<mutex> lock(guard);
+        writeFlow(flow.name, flow.totals);
+    }
+    flow.totals.clear();
+    flow.name = nullptr;
+}
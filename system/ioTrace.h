@@ -0,0 +1,91 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// ioTrace.h
+// Purpose: I/O accounting trace. With SUPERFERRY_IO_TRACE=<file> set,
+// every access the storage layer makes to a data file or the log is
+// counted (calls, system calls, bytes) per file and operation kind,
+// and summed over the user-level flow it happened in (createFlow,
+// deleteFlow, service.checkIn, ...). Each flow, when it ends, appends
+// its totals to the trace as CSV:
+//
+//     flow_seq,flow,file,op,calls,syscalls,bytes
+//     3,createFlow,reservations.dat,write,1,0,16
+//
+// The rows carry no timestamps or addresses, so the traces of two
+// releases running the same script can be diffed directly. I/O outside
+// any flow (start-up, the server's file checks) is written last, as
+// flow "-".
+//
+// Records are read and written through a shared mapping: read, write,
+// cache_read and scan count bytes copied with no system call; the
+// other kinds are one system call each (bytes: the range or data it
+// covered, 0 where there is none).
+//***************************************************
+
+#ifndef IO_TRACE_H
+#define IO_TRACE_H
+
+#include <string>
+
+//--------------------------------------
+// Kinds of access, in CSV order
+enum class IoOp {
+    READ,           // record bytes copied out of a mapping
+    CACHE_READ,     // record bytes served from the page cache
+    WRITE,          // record bytes copied into a mapping
+    SCAN,           // bytes a locked walk or key scan may read
+    OPEN,           // open()
+    STAT,           // fstat()/stat()
+    MAP,            // mmap() (bytes mapped)
+    RESIZE,         // ftruncate() (bytes: new size)
+    LOCK,           // fcntl() lock or unlock
+    SYS_READ,       // read()
+    SYS_WRITE,      // write()/pwrite()
+    SYNC            // msync()/fsync()/fdatasync()
+};
+
+class IoTrace {
+private:
+    static bool on;
+    static void add(IoOp op, const std::string& file, long long bytes);
+
+public:
+    //--------------------------------------
+    // Starts tracing into path (truncated). Returns false if it cannot
+    // be opened.
+    static bool open(const char* path);
+
+    //--------------------------------------
+    // Starts tracing if SUPERFERRY_IO_TRACE names a file.
+    static void configureFromEnv();
+
+    //--------------------------------------
+    // Writes the I/O seen outside any flow and stops tracing.
+    static void close();
+
+    //--------------------------------------
+    static bool active() { return on; }
+
+    //--------------------------------------
+    // Counts one access (a no-op unless tracing)
+    static void note(IoOp op, const std::string& file, long long bytes = 0) {
+        if (on) add(op, file, bytes);
+    }
+};
+
+//--------------------------------------
+// Class: IoFlow
+// Marks a user-level flow for the length of its scope. Flows nest: the
+// outermost one on the thread collects everything below it.
+class IoFlow {
+private:
+    bool outermost;
+
+public:
+    explicit IoFlow(const char* name);
+    ~IoFlow();
+    IoFlow(const IoFlow&) = delete;
+    IoFlow& operator=(const IoFlow&) = delete;
+};
+
+#endif // IO_TRACE_H
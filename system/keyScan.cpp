@@ -0,0 +1,163 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: keyScan.cpp
+// Purpose:
+//   SSE2, AVX2 and scalar key compare loops and the kernel selection.
+//   The AVX2 loop is compiled for AVX2 on its own (target attribute),
+//   so the build needs no -mavx2 and runs on any x86-64 CPU.
+//***************************************************
+
+#include "keyScan.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KEY_SCAN_X86 1
+#else
+#define KEY_SCAN_X86 0
+#endif
+
+using namespace std;
+
+namespace {
+    const int UNCHOSEN = -1;
+    atomic<int> chosen(UNCHOSEN);
+
+    //--------------------------------------
+    // Best kernel this CPU runs
+    ScanKernel bestKernel() {
+#if KEY_SCAN_X86
+        if (__builtin_cpu_supports("avx2")) return ScanKernel::AVX2;
+        return ScanKernel::SSE2;
+#else
+        return ScanKernel::SCALAR;
+#endif
+    }
+
+    //--------------------------------------
+    // Records [0, n) whose 16-byte load at the key stays inside the array
+    size_t wideCount(const KeyScan& scan) {
+        size_t bytes = scan.count * scan.stride;
+        if (scan.width > 16 || scan.offset + 16 > bytes) return 0;
+        return (bytes - scan.offset - 16) / scan.stride + 1;
+    }
+
+    //--------------------------------------
+    template <typename Sink>
+    void scalarRange(const KeyScan& scan, const void* key, size_t from, Sink& sink) {
+        const unsigned char* p = static_cast<const unsigned char*>(scan.records) + from * scan.stride + scan.offset;
+        for (size_t i = from; i < scan.count; ++i, p += scan.stride) {
+            if (memcmp(p, key, scan.width) == 0) sink(i);
+        }
+    }
+
+#if KEY_SCAN_X86
+    //--------------------------------------
+    // One record per compare; mask has a bit per key byte
+    template <typename Sink>
+    size_t sse2Range(const KeyScan& scan, const unsigned char* key16, unsigned mask, size_t n, Sink& sink) {
+        const __m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key16));
+        const unsigned char* p = static_cast<const unsigned char*>(scan.records) + scan.offset;
+        for (size_t i = 0; i < n; ++i, p += scan.stride) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned eq = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, key)));
+            if ((eq & mask) == mask) sink(i);
+        }
+        return n;
+    }
+
+    //--------------------------------------
+    // Two records per compare: one 32-byte load when records are 16
+    // bytes apart, two 16-byte loads otherwise
+    template <typename Sink>
+    __attribute__((target("avx2")))
+    size_t avx2Range(const KeyScan& scan, const unsigned char* key16, unsigned mask, size_t n, Sink& sink) {
+        const __m256i key = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(key16)));
+        const unsigned char* p = static_cast<const unsigned char*>(scan.records) + scan.offset;
+        const size_t stride = scan.stride;
+        size_t i = 0;
+
+        for (; i + 2 <= n; i += 2, p += 2 * stride) {
+            __m256i v;
+            if (stride == 16) {
+                v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            } else {
+                v = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + stride)), 1);
+            }
+            unsigned eq = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, key)));
+            if ((eq & mask) == mask) sink(i);
+            if (((eq >> 16) & mask) == mask) sink(i + 1);
+        }
+        return i;
+    }
+#endif
+
+    //--------------------------------------
+    // Vector loop over the records it can load safely, scalar for the rest
+    template <typename Sink>
+    void run(const KeyScan& scan, const void* key, Sink& sink) {
+        if (scan.count == 0 || scan.width == 0) return;
+        size_t done = 0;
+
+#if KEY_SCAN_X86
+        ScanKernel kernel = activeScanKernel();
+        size_t wide = (kernel == ScanKernel::SCALAR) ? 0 : wideCount(scan);
+        if (wide > 0) {
+            unsigned char key16[16] = { 0 };
+            memcpy(key16, key, scan.width);
+            unsigned mask = (scan.width == 16) ? 0xFFFFu : ((1u << scan.width) - 1);
+            done = (kernel == ScanKernel::AVX2) ? avx2Range(scan, key16, mask, wide, sink)
+                                                : sse2Range(scan, key16, mask, wide, sink);
+        }
+#endif
+        scalarRange(scan, key, done, sink);
+    }
+}
+
+//--------------------------------------
+size_t scanEqual(const KeyScan& scan, const void* key, vector<int>& hits) {
+    size_t before = hits.size();
+    auto sink = [&](size_t i) { hits.push_back(static_cast<int>(i)); };
+    run(scan, key, sink);
+    return hits.size() - before;
+}
+
+//--------------------------------------
+size_t countEqual(const KeyScan& scan, const void* key) {
+    size_t hits = 0;
+    auto sink = [&](size_t) { ++hits; };
+    run(scan, key, sink);
+    return hits;
+}
+
+//--------------------------------------
+ScanKernel setScanKernel(ScanKernel kernel) {
+    ScanKernel best = bestKernel();
+    if (kernel == ScanKernel::AUTO ||
+        (kernel == ScanKernel::AVX2 && best != ScanKernel::AVX2) ||
+        (kernel == ScanKernel::SSE2 && best == ScanKernel::SCALAR)) {
+        kernel = best;
+    }
+    chosen.store(static_cast<int>(kernel));
+    return kernel;
+}
+
+//--------------------------------------
+ScanKernel activeScanKernel() {
+    int kernel = chosen.load();
+    if (kernel == UNCHOSEN) return setScanKernel(ScanKernel::AUTO);
+    return static_cast<ScanKernel>(kernel);
+}
+
+//--------------------------------------
+const char* scanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::SCALAR: return "scalar";
+        case ScanKernel::SSE2:   return "sse2";
+        case ScanKernel::AVX2:   return "avx2";
+        default:                 return "auto";
+    }
+}
@@ -0,0 +1,57 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: keyScan.h
+// Purpose:
+//   Fixed-width key scans over a contiguous array of records (a mapped
+//   data file), for the bulk passes the hash indexes do not cover:
+//   the reservation cascade of a sailing deletion, the orphan purge,
+//   the onboard recount and the ferry-in-use checks.
+//
+//   A key is 1-16 bytes at a fixed offset in every record. Each record
+//   is compared 16 bytes at a time with SSE2, or two records per
+//   32-byte compare with AVX2, against the key under a byte mask; a
+//   byte-by-byte loop covers other CPUs and the last records of the
+//   array, where a 16-byte load could run past its end. The best
+//   kernel the CPU supports is chosen on first use.
+//***************************************************
+
+#ifndef KEY_SCAN_H
+#define KEY_SCAN_H
+
+#include <cstddef>
+#include <vector>
+
+//--------------------------------------
+// Compare loop used by the scans
+enum class ScanKernel { AUTO, SCALAR, SSE2, AVX2 };
+
+//--------------------------------------
+// Where the keys are: count records of stride bytes from records,
+// each with its key at offset (width bytes, 1-16)
+struct KeyScan {
+    const void* records;
+    size_t count;
+    size_t stride;
+    size_t offset;
+    size_t width;
+};
+
+//--------------------------------------
+// Appends the index of every record whose key equals key
+// Returns: number of indexes appended
+size_t scanEqual(const KeyScan& scan, const void* key, std::vector<int>& hits);
+
+//--------------------------------------
+// Counts the records whose key equals key
+size_t countEqual(const KeyScan& scan, const void* key);
+
+//--------------------------------------
+// Selects the kernel (AUTO = the best one the CPU supports; a kernel
+// the CPU lacks falls back the same way). Returns the kernel in use.
+ScanKernel setScanKernel(ScanKernel kernel);
+
+//--------------------------------------
+ScanKernel activeScanKernel();
+const char* scanKernelName(ScanKernel kernel);
+
+#endif // KEY_SCAN_H
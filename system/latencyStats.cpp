@@ -0,0 +1,150 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// latencyStats.cpp
+// Purpose: Probe table and per-thread counter blocks. A block is only
+// written by its own thread (relaxed load + store, no locked add);
+// the table mutex is taken when a probe registers, a thread counts for
+// the first time, and on snapshot()/reset(). Blocks are never freed,
+// so counts outlive their threads.
+//***************************************************
+
+#include "latencyStats.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace {
+    typedef atomic<unsigned long long> Counter;
+
+    struct ThreadCounts {
+        Counter buckets[LatencyStats::MAX_PROBES][LatencyStats::BUCKETS];
+        Counter totalNs[LatencyStats::MAX_PROBES];
+        Counter maxNs[LatencyStats::MAX_PROBES];
+    };
+
+    struct Table {
+        mutex guard;
+        vector<const char*> names;
+        vector<unique_ptr<ThreadCounts> > threads;
+    };
+
+    // never destroyed: threads may still record during static teardown
+    Table& table() {
+        static Table* t = new Table;
+        return *t;
+    }
+
+    thread_local ThreadCounts* mine = nullptr;
+
+    ThreadCounts& threadCounts() {
+        if (mine == nullptr) {
+            Table& t = table();
+            lock_guard<mutex> lock(t.guard);
+            t.threads.push_back(unique_ptr<ThreadCounts>(new ThreadCounts()));
+            mine = t.threads.back().get();
+        }
+        return *mine;
+    }
+
+    void add(Counter& c, unsigned long long value) {
+        c.store(c.load(memory_order_relaxed) + value, memory_order_relaxed);
+    }
+
+    int bucketOf(unsigned long long ns) {
+        int b = (ns == 0) ? 0 : 64 - __builtin_clzll(ns);
+        return b < LatencyStats::BUCKETS ? b : LatencyStats::BUCKETS - 1;
+    }
+
+    //--------------------------------------
+    // Upper bound (in microseconds) of the bucket holding the rank-th
+    // sample, rank counted from 1
+    double bucketLimitUs(const unsigned long long* buckets, unsigned long long rank) {
+        unsigned long long seen = 0;
+        for (int b = 0; b < LatencyStats::BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return static_cast<double>(1ULL << b) / 1000.0;
+        }
+        return static_cast<double>(1ULL << (LatencyStats::BUCKETS - 1)) / 1000.0;
+    }
+}
+
+//--------------------------------------
+LatencyProbe::LatencyProbe(const char* name) : slot(-1), label(name) {
+    Table& t = table();
+    lock_guard<mutex> lock(t.guard);
+    if (static_cast<int>(t.names.size()) >= LatencyStats::MAX_PROBES) {
+        cerr << "[WARN] Latency probe table full; " << name << " is not timed." << endl;
+        return;
+    }
+    slot = static_cast<int>(t.names.size());
+    t.names.push_back(name);
+}
+
+//--------------------------------------
+LatencyTimer::~LatencyTimer() {
+    chrono::nanoseconds elapsed = chrono::steady_clock::now() - started;
+    LatencyStats::record(probe, static_cast<unsigned long long>(elapsed.count()));
+}
+
+//--------------------------------------
+void LatencyStats::record(const LatencyProbe& probe, unsigned long long nanoseconds) {
+    int id = probe.id();
+    if (id < 0) return;
+    ThreadCounts& counts = threadCounts();
+    add(counts.buckets[id][bucketOf(nanoseconds)], 1);
+    add(counts.totalNs[id], nanoseconds);
+    if (nanoseconds > counts.maxNs[id].load(memory_order_relaxed)) {
+        counts.maxNs[id].store(nanoseconds, memory_order_relaxed);
+    }
+}
+
+//--------------------------------------
+vector<LatencySummary> LatencyStats::snapshot() {
+    Table& t = table();
+    lock_guard<mutex> lock(t.guard);
+
+    vector<LatencySummary> out;
+    for (size_t id = 0; id < t.names.size(); ++id) {
+        unsigned long long buckets[BUCKETS] = { 0 };
+        unsigned long long count = 0, totalNs = 0, maxNs = 0;
+        for (const unique_ptr<ThreadCounts>& counts : t.threads) {
+            for (int b = 0; b < BUCKETS; ++b) {
+                unsigned long long n = counts->buckets[id][b].load(memory_order_relaxed);
+                buckets[b] += n;
+                count += n;
+            }
+            totalNs += counts->totalNs[id].load(memory_order_relaxed);
+            unsigned long long m = counts->maxNs[id].load(memory_order_relaxed);
+            if (m > maxNs) maxNs = m;
+        }
+        if (count == 0) continue;
+
+        LatencySummary s;
+        s.name = t.names[id];
+        s.count = count;
+        s.totalMs = totalNs / 1e6;
+        s.meanUs = totalNs / 1e3 / count;
+        s.maxUs = maxNs / 1e3;
+        s.p50Us = min(bucketLimitUs(buckets, (count + 1) / 2), s.maxUs);
+        s.p99Us = min(bucketLimitUs(buckets, count - count / 100), s.maxUs);
+        out.push_back(s);
+    }
+    return out;
+}
+
+//--------------------------------------
+void LatencyStats::reset() {
+    Table& t = table();
+    lock_guard<mutex> lock(t.guard);
+    for (const unique_ptr<ThreadCounts>& counts : t.threads) {
+        for (int id = 0; id < MAX_PROBES; ++id) {
+            for (int b = 0; b < BUCKETS; ++b) counts->buckets[id][b].store(0, memory_order_relaxed);
+            counts->totalNs[id].store(0, memory_order_relaxed);
+            counts->maxNs[id].store(0, memory_order_relaxed);
+        }
+    }
+}
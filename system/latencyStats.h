@@ -0,0 +1,82 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// latencyStats.h
+// Purpose: Latency histograms for the hot paths (ASM primitives and
+// the service/manager flows), shown by the Diagnostics menu entry and
+// written to the --stats-file at shutdown().
+//
+// A call site names its operation once and times each call:
+//     static LatencyProbe latencyProbe("sailingASM.getRecord");
+//     LatencyTimer timer(latencyProbe);
+// Durations come from the monotonic clock and land in power-of-two
+// nanosecond buckets. Every thread counts into its own block, so
+// threads never share a counter; snapshot() merges the blocks
+// (including those of threads that have ended).
+//***************************************************
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+//--------------------------------------
+// A named, timed operation (register once, e.g. as a function static)
+class LatencyProbe {
+private:
+    int slot;                   // -1 when the probe table is full
+    const char* label;
+
+public:
+    explicit LatencyProbe(const char* name);
+    int id() const { return slot; }
+    const char* name() const { return label; }
+};
+
+//--------------------------------------
+// Times its own scope into a probe
+class LatencyTimer {
+private:
+    const LatencyProbe& probe;
+    std::chrono::steady_clock::time_point started;
+
+public:
+    explicit LatencyTimer(const LatencyProbe& p) : probe(p), started(std::chrono::steady_clock::now()) {}
+    ~LatencyTimer();
+    LatencyTimer(const LatencyTimer&) = delete;
+    LatencyTimer& operator=(const LatencyTimer&) = delete;
+};
+
+//--------------------------------------
+// Merged view of one probe. Percentiles are bucket upper bounds
+// (capped at the maximum), so they overstate by less than a factor of two.
+struct LatencySummary {
+    std::string name;
+    unsigned long long count;
+    double totalMs;
+    double meanUs;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+};
+
+class LatencyStats {
+public:
+    static const int MAX_PROBES = 96;
+    static const int BUCKETS = 40;      // bucket b holds [2^(b-1), 2^b) ns
+
+    //--------------------------------------
+    // Adds one duration (normally via LatencyTimer)
+    static void record(const LatencyProbe& probe, unsigned long long nanoseconds);
+
+    //--------------------------------------
+    // Every probe called at least once, in registration order
+    static std::vector<LatencySummary> snapshot();
+
+    //--------------------------------------
+    // Zeroes all counters (approximate while other threads record)
+    static void reset();
+};
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,146 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: socketChannel.cpp
+// Purpose:
+//   Unix socket connect, buffered line reads with an optional timeout,
+//   full writes and the client request/reply round trip.
+//***************************************************
+
+#include "socketChannel.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+const char* const DEFAULT_SOCKET_PATH = "superferry.sock";
+
+namespace {
+    const size_t MAX_LINE = 64 * 1024;  // longer lines end the connection
+}
+
+//--------------------------------------
+string wireLine(const vector<string>& fields) {
+    string line;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) line.push_back('\t');
+        line += fields[i];
+    }
+    return line;
+}
+
+//--------------------------------------
+vector<string> wireFields(const string& line) {
+    vector<string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == string::npos ? string::npos : tab - start));
+        if (tab == string::npos) break;
+        start = tab + 1;
+    }
+    return fields;
+}
+
+//--------------------------------------
+SocketChannel::SocketChannel() : fd(-1) {}
+
+SocketChannel::SocketChannel(int connectedFd) : fd(connectedFd) {}
+
+SocketChannel::~SocketChannel() {
+    close();
+}
+
+//--------------------------------------
+bool SocketChannel::connectTo(const string& path) {
+    close();
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int saved = errno;
+        close();
+        errno = saved;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------
+void SocketChannel::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    buffer.clear();
+}
+
+//--------------------------------------
+ReadStatus SocketChannel::readLine(string& line, int timeoutMs) {
+    if (fd < 0) return ReadStatus::CLOSED;
+
+    while (true) {
+        size_t newline = buffer.find('\n');
+        if (newline != string::npos) {
+            line.assign(buffer, 0, newline);
+            buffer.erase(0, newline + 1);
+            if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+            return ReadStatus::LINE;
+        }
+        if (buffer.size() > MAX_LINE) return ReadStatus::CLOSED;
+
+        if (timeoutMs >= 0) {
+            pollfd p = { fd, POLLIN, 0 };
+            int ready = ::poll(&p, 1, timeoutMs);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) return ReadStatus::TIMEOUT;
+            if (ready < 0) return ReadStatus::CLOSED;
+        }
+
+        char chunk[4096];
+        ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return ReadStatus::CLOSED;
+        buffer.append(chunk, static_cast<size_t>(got));
+    }
+}
+
+//--------------------------------------
+bool SocketChannel::writeAll(const string& data) {
+    if (fd < 0) return false;
+
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+//--------------------------------------
+bool SocketChannel::request(const vector<string>& fields, string& status,
+                            vector<string>* rows) {
+    status.clear();
+    if (rows) rows->clear();
+    if (!writeAll(wireLine(fields) + "\n")) return false;
+    if (readLine(status) != ReadStatus::LINE) return false;
+
+    string line;
+    while (readLine(line) == ReadStatus::LINE) {
+        if (line == ".") return true;
+        if (rows) rows->push_back(line);
+    }
+    return false;
+}
@@ -0,0 +1,94 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// Module: socketChannel.h
+// Purpose:
+//   Line-oriented stream over a Unix domain socket, shared by
+//   `superferry serve`, the booth client and the benchmark.
+//
+//   Wire format: one request per line, fields separated by tabs.
+//   A reply is a status line ("OK[\t...]" or "ERR\t<reason>"), zero or
+//   more data lines, and a line holding a single ".". Fields never
+//   contain tabs or newlines, so no escaping is needed.
+//***************************************************
+
+#ifndef SOCKET_CHANNEL_H
+#define SOCKET_CHANNEL_H
+
+#include <string>
+#include <vector>
+
+//--------------------------------------
+// Default socket, created in the data directory
+extern const char* const DEFAULT_SOCKET_PATH;
+
+//--------------------------------------
+// Joins fields with tabs into one request or reply line
+std::string wireLine(const std::vector<std::string>& fields);
+
+//--------------------------------------
+// Splits a request or reply line on tabs
+std::vector<std::string> wireFields(const std::string& line);
+
+//--------------------------------------
+// Outcome of SocketChannel::readLine()
+enum class ReadStatus {
+    LINE,       // a whole line was read
+    TIMEOUT,    // nothing complete arrived in time; the stream is still open
+    CLOSED      // end of stream, an error, or an over-long line
+};
+
+class SocketChannel {
+private:
+    int fd;
+    std::string buffer;     // bytes received but not yet returned as lines
+
+public:
+    SocketChannel();
+    explicit SocketChannel(int connectedFd);   // takes ownership (server side)
+    ~SocketChannel();
+
+    //--------------------------------------
+    bool connectTo(
+        const std::string& path  // in: socket path
+    );
+    /*
+    Connects to a listening server. Returns false (errno set) if nobody
+    is listening there.
+    */
+
+    //--------------------------------------
+    bool isOpen() const { return fd >= 0; }
+    int handle() const { return fd; }
+    void close();
+
+    //--------------------------------------
+    ReadStatus readLine(
+        std::string& line,  // out: next line without the newline
+        int timeoutMs = -1  // in: give up after this long (-1 = wait)
+    );
+    /*
+    TIMEOUT only when a poll ran out; once the peer has closed (or the
+    socket failed) every call returns CLOSED.
+    */
+
+    //--------------------------------------
+    bool writeAll(
+        const std::string& data  // in: bytes to send
+    );
+    /*
+    Sends everything or returns false. Never raises SIGPIPE.
+    */
+
+    //--------------------------------------
+    bool request(
+        const std::vector<std::string>& fields,  // in: verb and arguments
+        std::string& status,                     // out: reply status line
+        std::vector<std::string>* rows = nullptr // out (optional): data lines
+    );
+    /*
+    Client side: sends one request and reads its whole reply. Returns
+    false if the connection failed; the server's verdict is in status.
+    */
+};
+
+#endif // SOCKET_CHANNEL_H
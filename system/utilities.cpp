@@ -8,50 +8,102 @@
 // for all major functional modules in the SuperFerry system.
 //***************************************************
 #include <iostream>
+#include <fstream>
+#include <iomanip>
 #include "utilities.h"
-#include "../entity/ferryASM.h"
-#include "../entity/reservationASM.h"
-#include "../entity/sailingASM.h"
-#include "../entity/vehicleASM.h"
+#include "../entity/pageCache.h"
+#include "../entity/storeRegistry.h"
+#include "ioTrace.h"
+#include "keyScan.h"
+#include "latencyStats.h"
+#include "writeAheadLog.h"
+#include "writeBehind.h"
 
 using namespace std;
 
+namespace {
+    string statsFile;
+    bool running = false;       // between start() and shutdown()
+
+    //--------------------------------------
+    // The diagnostics as JSON lines: one per timed operation, then the
+    // page cache and scan kernel
+    bool writeStats(const string& path) {
+        ofstream out(path.c_str(), ios::trunc);
+        if (!out) return false;
+        out.setf(ios::fixed);
+        out.precision(3);
+        for (const LatencySummary& s : LatencyStats::snapshot()) {
+            out << "{\"op\":\"" << s.name << "\""
+                << ",\"calls\":" << s.count
+                << ",\"total_ms\":" << s.totalMs
+                << ",\"mean_us\":" << s.meanUs
+                << ",\"p50_us\":" << s.p50Us
+                << ",\"p99_us\":" << s.p99Us
+                << ",\"max_us\":" << s.maxUs << "}\n";
+        }
+        PageCacheStats cache = PageCache::stats();
+        out << "{\"page_cache\":{\"hits\":" << cache.hits
+            << ",\"misses\":" << cache.misses
+            << ",\"evictions\":" << cache.evictions
+            << ",\"writes\":" << cache.writes
+            << ",\"pages\":" << cache.pages
+            << ",\"capacity\":" << cache.capacity << "}"
+            << ",\"scan_kernel\":\"" << scanKernelName(activeScanKernel()) << "\"}\n";
+        return static_cast<bool>(out);
+    }
+}
+
 //--------------------------------------
 // Function: start
 // Purpose : Starts up all subsystems and initializes resources.
 //--------------------------------------
-void start() {
-    cout << "[System] Startup complete. Resources initialized.\n";
+bool start() {
+    IoTrace::configureFromEnv();
+    IoFlow ioFlow("start");
 
-    FerryASM::initialize();
+    // bring the data files up to date before anything maps them
+    WriteAheadLog::open();
+    WriteAheadLog::configureFromEnv();
+    if (WriteAheadLog::replay() > 0) StoreRegistry::noteRecovery();
+    PageCache::configureFromEnv();
+    WriteBehind::configureFromEnv();
 
-    ReservationASM reservations;
-    reservations.initialize();
-    
-    SailingASM sailings;
-    sailings.initialize();
-    
-    VehicleASM vehicles;
-    vehicles.initialize();
+    // one handle per data file for the rest of the process (in memory
+    // mode, one table each, kept written back by the writer thread)
+    if (!StoreRegistry::openAll()) {
+        cerr << "[ERROR] Startup failed: the data files could not be opened." << endl;
+        WriteAheadLog::close();
+        return false;
+    }
+    WriteBehind::startWriter();
+    running = true;
+    cout << "[System] Startup complete. Resources initialized.\n";
+    return true;
 }
 
 //--------------------------------------
 // Function: shutdown
-// Purpose : Gracefully closes all modules and flushes data.
+// Purpose : Gracefully closes all modules and flushes data (in memory
+//           mode, a snapshot of every table). Runs once per start().
 //--------------------------------------
 void shutdown() {
+    if (!running) return;
+    running = false;
     cout << "[System] Shutdown complete. All data saved.\n";
 
-    FerryASM::shutdown();
-
-    ReservationASM reservations;
-    reservations.shutdown();
+    {
+        IoFlow ioFlow("shutdown");
+        WriteBehind::stopWriter();
+        StoreRegistry::closeAll();
 
-    SailingASM sailings;
-    sailings.shutdown();
+        if (!statsFile.empty() && !writeStats(statsFile)) {
+            cerr << "[WARN] Could not write statistics to " << statsFile << endl;
+        }
 
-    VehicleASM vehicles;
-    vehicles.shutdown();
+        WriteAheadLog::close();
+    }
+    IoTrace::close();
 }
 
 //--------------------------------------
@@ -61,15 +113,56 @@ void shutdown() {
 //--------------------------------------
 void reset() {
     cout << "[System] System reset triggered.\n";
+    IoFlow ioFlow("reset");
 
+    // through the shared handles, so every user sees empty indexes
     FerryASM::reset();
+    StoreRegistry::reservations().reset();
+    StoreRegistry::sailings().reset();
+    StoreRegistry::vehicles().reset();
+
+    WriteAheadLog::checkpoint();
+}
 
-    ReservationASM reservations;
-    reservations.reset();
+//--------------------------------------
+// Function: printDiagnostics
+// Purpose : Latency table (microseconds; p50/p99 are the upper bounds
+//           of power-of-two buckets), then the page cache and kernel.
+//--------------------------------------
+void printDiagnostics(ostream& out) {
+    vector<LatencySummary> ops = LatencyStats::snapshot();
 
-    SailingASM sailings;
-    sailings.reset();
+    out << setfill(' ');
+    out << "\n=============================== Diagnostics ===============================\n";
+    if (ops.empty()) {
+        out << "No timed operations yet.\n";
+    } else {
+        out << left << setw(40) << "Operation" << right
+            << setw(8) << "Calls" << setw(10) << "Mean us"
+            << setw(9) << "p50 us" << setw(9) << "p99 us" << setw(10) << "Max us" << "\n";
+        out << fixed << setprecision(1);
+        for (const LatencySummary& s : ops) {
+            out << left << setw(40) << s.name << right
+                << setw(8) << s.count << setw(10) << s.meanUs
+                << setw(9) << s.p50Us << setw(9) << s.p99Us << setw(10) << s.maxUs << "\n";
+        }
+        out.unsetf(ios::fixed);
+    }
 
-    VehicleASM vehicles;
-    vehicles.reset();
+    PageCacheStats cache = PageCache::stats();
+    unsigned long long reads = cache.hits + cache.misses;
+    out << "\nPage cache: " << cache.hits << " hits, " << cache.misses << " misses";
+    if (reads > 0) out << " (" << fixed << setprecision(1) << 100.0 * cache.hits / reads << "% hit rate)";
+    out << ", " << cache.pages << "/" << cache.capacity << " pages, "
+        << cache.evictions << " evictions\n";
+    out.unsetf(ios::fixed);
+    out << "Key scan kernel: " << scanKernelName(activeScanKernel()) << "\n";
+    out << "===========================================================================\n" << endl;
+}
+
+//--------------------------------------
+// Function: setStatsFile
+//--------------------------------------
+void setStatsFile(const string& path) {
+    statsFile = path;
 }
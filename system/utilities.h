@@ -11,6 +11,9 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+#include <iosfwd>
+#include <string>
+
 //--------------------------------------
 // Function: initialize
 // Purpose : Initializes core system structures before main control loop.
@@ -21,9 +24,11 @@ void initialize();
 //--------------------------------------
 // Function: start
 // Purpose : Starts all subsystems (UI, ReservationManager, etc.).
+// Returns : false if a data file could not be opened (for instance, in
+//           in-memory mode, while another process has the store)
 // Notes   : Typically called immediately after `initialize()`.
 //--------------------------------------
-void start();
+bool start();
 
 //--------------------------------------
 // Function: shutdown
@@ -39,4 +44,18 @@ void shutdown();
 //--------------------------------------
 void reset();
 
+//--------------------------------------
+// Function: printDiagnostics
+// Purpose : Prints the latency of each timed operation, the page cache
+//           counters and the key scan kernel in use.
+//--------------------------------------
+void printDiagnostics(std::ostream& out);
+
+//--------------------------------------
+// Function: setStatsFile
+// Purpose : Names the file shutdown() writes the same figures to, one
+//           JSON object per line (empty = none).
+//--------------------------------------
+void setStatsFile(const std::string& path);
+
 #endif // UTILITIES_H
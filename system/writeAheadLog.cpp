@@ -0,0 +1,535 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// writeAheadLog.cpp
+// Purpose: Redo log for all record-file mutations.
+//
+// Entry layout (little-endian, packed):
+//   magic u32 | type u8 | pathLen u16 | dataLen u32 | offset i64 |
+//   checksum u32 | path bytes | data bytes
+// type 'W' = write dataLen bytes at offset, 'R' = resize file to offset,
+// 'C' = commit marker closing the group of entries before it.
+// Replay applies a group only once its commit marker has been read
+// intact; a torn tail is ignored.
+//***************************************************
+
+#include "writeAheadLog.h"
+#include "writeBehind.h"
+#include "ioTrace.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <map>
+#include <set>
+#include <functional>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    const unsigned int  WAL_MAGIC      = 0x4C415753;     // "SWAL"
+    const unsigned char ENTRY_WRITE    = 'W';
+    const unsigned char ENTRY_RESIZE   = 'R';
+    const unsigned char ENTRY_COMMIT   = 'C';
+    const size_t        HEADER_SIZE    = 4 + 1 + 2 + 4 + 8 + 4;
+    const long long     CHECKPOINT_AT  = 4LL * 1024 * 1024;  // log size that triggers a checkpoint
+
+    // FNV-1a over the entry body (everything but magic and checksum)
+    unsigned int checksum(unsigned char type, const char* path, size_t pathLen,
+                          long long offset, const char* data, size_t dataLen) {
+        unsigned int h = 2166136261u;
+        auto mix = [&h](const char* p, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                h ^= static_cast<unsigned char>(p[i]);
+                h *= 16777619u;
+            }
+        };
+        mix(reinterpret_cast<const char*>(&type), 1);
+        mix(path, pathLen);
+        mix(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        mix(data, dataLen);
+        return h;
+    }
+
+    int syncFd(int fd) {
+#if defined(__APPLE__)
+        return fsync(fd);
+#else
+        return fdatasync(fd);
+#endif
+    }
+
+    // Sync a data file by path (works for pages dirtied through mmap too)
+    void syncPath(const string& path) {
+        IoTrace::note(IoOp::OPEN, path);
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0) return;
+        IoTrace::note(IoOp::SYNC, path);
+        fsync(fd);
+        ::close(fd);
+    }
+
+    // Byte ranges of the log used as locks between processes: every open
+    // log holds SESSION_BYTE shared; commit writes hold the entry range
+    // [0, SESSION_BYTE) shared and checkpoint() holds it exclusively.
+    const long long SESSION_BYTE = 1LL << 62;
+#if defined(F_OFD_SETLKW)
+    const int LOCK_TRY = F_OFD_SETLK, LOCK_WAIT = F_OFD_SETLKW;
+#else
+    const int LOCK_TRY = F_SETLK, LOCK_WAIT = F_SETLKW;
+#endif
+
+    bool lockLog(const string& path, int fd, short type, long long start, long long len, bool wait) {
+        IoTrace::note(IoOp::LOCK, path);
+        struct flock fl;
+        memset(&fl, 0, sizeof(fl));
+        fl.l_type   = type;
+        fl.l_whence = SEEK_SET;
+        fl.l_start  = static_cast<off_t>(start);
+        fl.l_len    = static_cast<off_t>(len);
+        while (fcntl(fd, wait ? LOCK_WAIT : LOCK_TRY, &fl) != 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+    }
+
+    struct Entry {
+        unsigned char type;
+        string path;
+        long long offset;
+        const char* data;
+        unsigned int len;
+    };
+
+    // Walks the log, handing each group closed by an intact commit
+    // marker to onGroup. A torn or corrupt tail ends the walk.
+    int parseLog(const vector<char>& log, const function<void(const vector<Entry>&)>& onGroup) {
+        vector<Entry> group;
+        int groups = 0;
+        size_t pos = 0;
+
+        while (pos + HEADER_SIZE <= log.size()) {
+            const char* p = &log[pos];
+            unsigned int magic, len, sum;
+            unsigned char type;
+            unsigned short pathLen;
+            long long offset;
+            memcpy(&magic, p, 4);       p += 4;
+            memcpy(&type, p, 1);        p += 1;
+            memcpy(&pathLen, p, 2);     p += 2;
+            memcpy(&len, p, 4);         p += 4;
+            memcpy(&offset, p, 8);      p += 8;
+            memcpy(&sum, p, 4);         p += 4;
+
+            if (magic != WAL_MAGIC || pos + HEADER_SIZE + pathLen + len > log.size()) break;
+            const char* path = p;
+            const char* data = p + pathLen;
+            if (checksum(type, path, pathLen, offset, data, len) != sum) break;
+            pos += HEADER_SIZE + pathLen + len;
+
+            if (type != ENTRY_COMMIT) {
+                Entry e = { type, string(path, pathLen), offset, data, len };
+                group.push_back(e);
+                continue;
+            }
+            onGroup(group);
+            group.clear();
+            ++groups;
+        }
+        return groups;
+    }
+}
+
+int                 WriteAheadLog::fd = -1;
+std::string         WriteAheadLog::logPath;
+std::vector<char>   WriteAheadLog::pending;
+std::vector<std::string> WriteAheadLog::touched;
+Durability          WriteAheadLog::mode = Durability::GROUP_COMMIT;
+int                 WriteAheadLog::commitsPerSync = 1;
+int                 WriteAheadLog::unsyncedCommits = 0;
+long long           WriteAheadLog::logBytes = 0;
+bool                WriteAheadLog::txnOpen = false;
+bool                WriteAheadLog::implicitGroup = false;
+std::vector<StagedWriter*> WriteAheadLog::participants;
+std::vector<StagedWriter*> WriteAheadLog::lockHolders;
+unsigned long       WriteAheadLog::abortCount = 0;
+
+//--------------------------------------
+bool WriteAheadLog::open(const char* path) {
+    if (fd >= 0) return true;
+
+    fd = ::open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        cerr << "[ERROR] Could not open write-ahead log " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    logPath = path;
+    IoTrace::note(IoOp::OPEN, logPath);
+
+    struct stat st;
+    IoTrace::note(IoOp::STAT, logPath);
+    logBytes = (fstat(fd, &st) == 0) ? static_cast<long long>(st.st_size) : 0;
+
+    // waits only while another process is replaying
+    if (!lockLog(logPath, fd, F_RDLCK, SESSION_BYTE, 1, true)) {
+        cerr << "[WARN] Could not lock write-ahead log " << path << ": " << strerror(errno) << endl;
+    }
+    return true;
+}
+
+//--------------------------------------
+void WriteAheadLog::close() {
+    if (fd < 0) return;
+    commit();
+    checkpoint();
+    ::close(fd);
+    fd = -1;
+}
+
+//--------------------------------------
+void WriteAheadLog::setDurability(Durability newMode, int groupSize) {
+    commit();
+    mode = newMode;
+    commitsPerSync = (groupSize < 1) ? 1 : groupSize;
+}
+
+//--------------------------------------
+Durability WriteAheadLog::durability() {
+    return mode;
+}
+
+//--------------------------------------
+void WriteAheadLog::configureFromEnv() {
+    Durability newMode = mode;
+    int groupSize = commitsPerSync;
+
+    const char* env = getenv("SUPERFERRY_DURABILITY");
+    if (env != nullptr) {
+        string value = env;
+        if (value == "buffered")      newMode = Durability::BUFFERED;
+        else if (value == "group")    newMode = Durability::GROUP_COMMIT;
+        else if (value == "fsync")    newMode = Durability::FSYNC_PER_OP;
+        else cerr << "[WARN] Unknown SUPERFERRY_DURABILITY '" << value << "', keeping default." << endl;
+    }
+
+    const char* group = getenv("SUPERFERRY_GROUP_COMMITS");
+    if (group != nullptr) {
+        int n = atoi(group);
+        if (n >= 1) groupSize = n;
+    }
+
+    setDurability(newMode, groupSize);
+}
+
+//--------------------------------------
+void WriteAheadLog::noteTouched(const string& file) {
+    if (find(touched.begin(), touched.end(), file) == touched.end()) {
+        touched.push_back(file);
+    }
+}
+
+//--------------------------------------
+// Serialize one entry onto the pending buffer
+void WriteAheadLog::appendEntry(unsigned char type, const string& file,
+                                long long offset, const void* data, unsigned int len) {
+    unsigned short pathLen = static_cast<unsigned short>(file.size());
+    const char* bytes = static_cast<const char*>(data);
+    unsigned int sum = checksum(type, file.data(), pathLen, offset, bytes, len);
+
+    size_t at = pending.size();
+    pending.resize(at + HEADER_SIZE + pathLen + len);
+    char* p = &pending[at];
+
+    memcpy(p, &WAL_MAGIC, 4);   p += 4;
+    memcpy(p, &type, 1);        p += 1;
+    memcpy(p, &pathLen, 2);     p += 2;
+    memcpy(p, &len, 4);         p += 4;
+    memcpy(p, &offset, 8);      p += 8;
+    memcpy(p, &sum, 4);         p += 4;
+    memcpy(p, file.data(), pathLen); p += pathLen;
+    if (len > 0) memcpy(p, bytes, len);
+}
+
+//--------------------------------------
+// One write() for everything pending, optionally followed by fdatasync.
+// Runs under the shared entry lock so a checkpoint cannot truncate the
+// group away before it is synced.
+bool WriteAheadLog::writePending(bool sync) {
+    lockLog(logPath, fd, F_RDLCK, 0, SESSION_BYTE, true);
+    bool ok = true;
+    size_t done = 0;
+    while (done < pending.size()) {
+        IoTrace::note(IoOp::SYS_WRITE, logPath, static_cast<long long>(pending.size() - done));
+        ssize_t n = ::write(fd, pending.data() + done, pending.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            cerr << "[ERROR] Write-ahead log write failed: " << strerror(errno) << endl;
+            ok = false;
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    if (ok) {
+        logBytes += static_cast<long long>(pending.size());
+        pending.clear();
+
+        if (sync) IoTrace::note(IoOp::SYNC, logPath);
+        if (sync && syncFd(fd) != 0) {
+            cerr << "[ERROR] Write-ahead log sync failed: " << strerror(errno) << endl;
+            ok = false;
+        }
+    }
+    lockLog(logPath, fd, F_UNLCK, 0, SESSION_BYTE, true);
+    return ok;
+}
+
+//--------------------------------------
+void WriteAheadLog::logWrite(const string& file, long long offset,
+                             const void* data, unsigned int len) {
+    if (fd < 0) return;
+    noteTouched(file);
+    appendEntry(ENTRY_WRITE, file, offset, data, len);
+}
+
+//--------------------------------------
+void WriteAheadLog::logResize(const string& file, long long newSize) {
+    if (fd < 0) return;
+    noteTouched(file);
+    appendEntry(ENTRY_RESIZE, file, newSize, nullptr, 0);
+}
+
+//--------------------------------------
+bool WriteAheadLog::commit() {
+    bool wasTxn = txnOpen;
+    bool ok = true;
+
+    if (fd >= 0 && !pending.empty()) {
+        appendEntry(ENTRY_COMMIT, string(), 0, nullptr, 0);
+
+        bool sync = false;
+        if (mode == Durability::FSYNC_PER_OP) {
+            sync = true;
+        } else if (mode == Durability::GROUP_COMMIT) {
+            if (++unsyncedCommits >= commitsPerSync) {
+                sync = true;
+                unsyncedCommits = 0;
+            }
+        }
+        ok = writePending(sync);
+    }
+
+    if (wasTxn) {
+        if (!ok) {
+            abort();
+            return false;
+        }
+        // the group is logged: now let the staged changes reach the files
+        txnOpen = false;
+        implicitGroup = false;
+        vector<StagedWriter*> writers;
+        writers.swap(participants);
+        for (StagedWriter* w : writers) {
+            if (!w->applyStaged()) ok = false;
+        }
+    }
+    releaseAllLocks();
+
+    // other processes append too: go by the real size before checkpointing
+    if (ok && logBytes >= CHECKPOINT_AT) {
+        struct stat st;
+        if (fstat(fd, &st) == 0) logBytes = static_cast<long long>(st.st_size);
+        if (logBytes >= CHECKPOINT_AT) ok = checkpoint();
+    }
+    return ok;
+}
+
+//--------------------------------------
+bool WriteAheadLog::begin() {
+    if (txnOpen && !implicitGroup) return false;
+    commit();               // keep earlier work out of this group
+    txnOpen = true;
+    return true;
+}
+
+//--------------------------------------
+// With the log closed there is nothing to write ahead of the change,
+// so the caller applies it at once.
+bool WriteAheadLog::stageMutation() {
+    if (txnOpen) return true;
+    if (fd < 0) return false;
+    txnOpen = true;
+    implicitGroup = true;
+    return true;
+}
+
+//--------------------------------------
+void WriteAheadLog::abort() {
+    if (!txnOpen) return;
+    txnOpen = false;
+    implicitGroup = false;
+    pending.clear();        // begin() left nothing else pending
+    abortCount++;
+
+    vector<StagedWriter*> writers;
+    writers.swap(participants);
+    for (StagedWriter* w : writers) {
+        w->discardStaged();
+    }
+    releaseAllLocks();
+}
+
+//--------------------------------------
+bool WriteAheadLog::inTransaction() {
+    return txnOpen && !implicitGroup;
+}
+
+//--------------------------------------
+unsigned long WriteAheadLog::aborts() {
+    return abortCount;
+}
+
+//--------------------------------------
+void WriteAheadLog::enlist(StagedWriter* writer) {
+    if (find(participants.begin(), participants.end(), writer) == participants.end()) {
+        participants.push_back(writer);
+    }
+}
+
+//--------------------------------------
+void WriteAheadLog::delist(StagedWriter* writer) {
+    participants.erase(remove(participants.begin(), participants.end(), writer), participants.end());
+}
+
+//--------------------------------------
+void WriteAheadLog::enlistLocks(StagedWriter* writer) {
+    if (find(lockHolders.begin(), lockHolders.end(), writer) == lockHolders.end()) {
+        lockHolders.push_back(writer);
+    }
+}
+
+//--------------------------------------
+void WriteAheadLog::delistLocks(StagedWriter* writer) {
+    lockHolders.erase(remove(lockHolders.begin(), lockHolders.end(), writer), lockHolders.end());
+}
+
+//--------------------------------------
+void WriteAheadLog::releaseAllLocks() {
+    vector<StagedWriter*> holders;
+    holders.swap(lockHolders);
+    for (StagedWriter* w : holders) {
+        w->releaseLocks();
+    }
+}
+
+//--------------------------------------
+// Reads the whole log (bounded by CHECKPOINT_AT plus one group per process)
+bool WriteAheadLog::readLog(vector<char>& log) {
+    log.clear();
+    char chunk[65536];
+    if (lseek(fd, 0, SEEK_SET) < 0) return false;
+    while (true) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        IoTrace::note(IoOp::SYS_READ, logPath, n);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break;
+        log.insert(log.end(), chunk, chunk + n);
+    }
+    return true;
+}
+
+//--------------------------------------
+bool WriteAheadLog::checkpoint() {
+    if (fd < 0 || (txnOpen && !implicitGroup)) return false;
+    if (!pending.empty() || implicitGroup) commit();
+
+    // no commit write may land between the syncs and the truncate
+    if (!lockLog(logPath, fd, F_WRLCK, 0, SESSION_BYTE, true)) {
+        cerr << "[ERROR] Could not lock write-ahead log: " << strerror(errno) << endl;
+        return false;
+    }
+
+    // tables kept in memory reach their files first (writeBehind.h)
+    WriteBehind::flushAll();
+
+    // groups in the log may come from other processes: sync their files too
+    set<string> files(touched.begin(), touched.end());
+    vector<char> log;
+    if (readLog(log)) {
+        parseLog(log, [&files](const vector<Entry>& group) {
+            for (const Entry& e : group) files.insert(e.path);
+        });
+    }
+    for (const string& file : files) {
+        syncPath(file);
+    }
+    touched.clear();
+
+    IoTrace::note(IoOp::RESIZE, logPath, 0);
+    bool ok = ftruncate(fd, 0) == 0;
+    if (!ok) {
+        cerr << "[ERROR] Could not truncate write-ahead log: " << strerror(errno) << endl;
+    } else {
+        logBytes = 0;
+        unsyncedCommits = 0;
+    }
+    lockLog(logPath, fd, F_UNLCK, 0, SESSION_BYTE, true);
+    return ok;
+}
+
+//--------------------------------------
+int WriteAheadLog::replay() {
+    if (fd < 0) return 0;
+
+    // another live session means the log is in use, not left over
+    if (!lockLog(logPath, fd, F_WRLCK, SESSION_BYTE, 1, false)) return 0;
+
+    vector<char> log;
+    if (!readLog(log)) {
+        lockLog(logPath, fd, F_RDLCK, SESSION_BYTE, 1, true);
+        return 0;
+    }
+
+    map<string, int> files;     // data file -> descriptor while replaying
+
+    // each committed group is applied in log order
+    int groups = parseLog(log, [&files](const vector<Entry>& group) {
+        for (const Entry& e : group) {
+            auto it = files.find(e.path);
+            if (it == files.end()) {
+                IoTrace::note(IoOp::OPEN, e.path);
+                int dfd = ::open(e.path.c_str(), O_RDWR | O_CREAT, 0644);
+                if (dfd < 0) continue;
+                it = files.insert(make_pair(e.path, dfd)).first;
+            }
+            if (e.type == ENTRY_WRITE) {
+                IoTrace::note(IoOp::SYS_WRITE, e.path, e.len);
+                if (pwrite(it->second, e.data, e.len, static_cast<off_t>(e.offset)) < 0) {
+                    cerr << "[ERROR] Replay write failed on " << e.path << endl;
+                }
+            } else if (e.type == ENTRY_RESIZE) {
+                IoTrace::note(IoOp::RESIZE, e.path, e.offset);
+                if (ftruncate(it->second, static_cast<off_t>(e.offset)) != 0) {
+                    cerr << "[ERROR] Replay resize failed on " << e.path << endl;
+                }
+            }
+        }
+    });
+
+    for (auto& f : files) {
+        IoTrace::note(IoOp::SYNC, f.first);
+        fsync(f.second);
+        ::close(f.second);
+    }
+
+    IoTrace::note(IoOp::RESIZE, logPath, 0);
+    if (ftruncate(fd, 0) == 0) logBytes = 0;
+    lockLog(logPath, fd, F_RDLCK, SESSION_BYTE, 1, true);     // back to an ordinary session
+    if (groups > 0) {
+        cout << "[System] Recovered " << groups << " committed operation(s) from " << logPath << ".\n";
+    }
+    return groups;
+}
@@ -0,0 +1,168 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// writeAheadLog.h
+// Purpose: Redo log for all record-file mutations.
+// Every write/resize made through RecordFile<T> is appended to
+// superferry.wal; a logical operation (a booking, a check-in, ...)
+// ends with commit(), which writes the group with a single write()
+// and, depending on the durability mode, one fdatasync. start()
+// replays committed groups left behind by a crash.
+//
+// A Transaction groups mutations across several record files: they
+// are staged in memory, written to the log together on commit(), and
+// only then applied to the data files. Abandoning it discards them.
+// Mutations made outside a Transaction are staged the same way, in an
+// implicit group that the next commit() logs and applies, so a data
+// file never holds part of an operation the log cannot redo.
+//
+// The log may be shared by several processes on one data directory.
+// Each holds a shared session lock on it while open; replay() only runs
+// when no other session is live, and checkpoint() excludes concurrent
+// commit writes while it syncs every file named in the log.
+//***************************************************
+
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <string>
+#include <vector>
+
+//--------------------------------------
+// Durability modes
+//   BUFFERED     - log written at commit, synced only at checkpoint
+//   GROUP_COMMIT - one fdatasync per group of commits (default group = 1)
+//   FSYNC_PER_OP - every commit synced before its changes are applied
+enum class Durability { BUFFERED, GROUP_COMMIT, FSYNC_PER_OP };
+
+//--------------------------------------
+// Interface for files that hold staged changes during a transaction
+// and record locks until the operation ends (implemented by RecordFile<T>).
+class StagedWriter {
+public:
+    virtual ~StagedWriter() {}
+    virtual bool applyStaged() = 0;     // write staged changes to the file
+    virtual void discardStaged() = 0;   // drop them
+    virtual void releaseLocks() = 0;    // drop the locks held for the operation
+};
+
+class WriteAheadLog {
+private:
+    static int fd;                          // log descriptor, -1 when closed
+    static std::string logPath;
+    static std::vector<char> pending;       // entries not yet written
+    static std::vector<std::string> touched;// data files changed since checkpoint
+    static Durability mode;
+    static int commitsPerSync;              // GROUP_COMMIT batch size
+    static int unsyncedCommits;
+    static long long logBytes;              // current log size
+    static bool txnOpen;                    // mutations are being staged
+    static bool implicitGroup;              // ... by an operation outside a Transaction
+    static std::vector<StagedWriter*> participants;
+    static std::vector<StagedWriter*> lockHolders;  // files holding locks for this operation
+    static unsigned long abortCount;        // transactions discarded so far
+
+    static void appendEntry(unsigned char type, const std::string& file,
+                            long long offset, const void* data, unsigned int len);
+    static bool writePending(bool sync);
+    static void noteTouched(const std::string& file);
+    static void releaseAllLocks();
+    static bool readLog(std::vector<char>& log);
+
+public:
+    //--------------------------------------
+    // Opens (creating if needed) the log file.
+    // Returns true on success.
+    static bool open(const char* path = "superferry.wal");
+
+    //--------------------------------------
+    // Re-applies every committed group found in the log to the data
+    // files, syncs them, and empties the log. Call before any ASM
+    // initialize(). Skipped while another process has the log open, as
+    // its groups are then live, not left over. Returns the number of
+    // groups replayed.
+    static int replay();
+
+    //--------------------------------------
+    // Commits anything pending, checkpoints and closes the log.
+    static void close();
+
+    //--------------------------------------
+    // Durability configuration. configureFromEnv() reads
+    // SUPERFERRY_DURABILITY (buffered | group | fsync) and
+    // SUPERFERRY_GROUP_COMMITS (commits per fdatasync).
+    static void setDurability(Durability newMode, int groupSize = 1);
+    static Durability durability();
+    static void configureFromEnv();
+
+    //--------------------------------------
+    // Mutation records, called by RecordFile<T>. No-ops while closed.
+    static void logWrite(const std::string& file, long long offset,
+                         const void* data, unsigned int len);
+    static void logResize(const std::string& file, long long newSize);
+
+    //--------------------------------------
+    // Ends a logical operation: writes the pending group plus a commit
+    // marker in one write() and syncs according to the durability mode.
+    // The staged changes are applied to the data files after the group
+    // is in the log; if it cannot be written they are discarded.
+    static bool commit();
+
+    //--------------------------------------
+    // Transactions (normally used through the Transaction class).
+    // begin() commits anything outstanding first and returns false if
+    // a transaction is already open; abort() discards staged changes.
+    static bool begin();
+    static void abort();
+    static bool inTransaction();
+
+    //--------------------------------------
+    // Called by RecordFile<T> before each mutation. True if it is to be
+    // staged: always while the log is open, opening the implicit group
+    // outside a Transaction. False only when the log is closed.
+    static bool stageMutation();
+    static unsigned long aborts();          // changes when in-memory indexes may be stale
+    static void enlist(StagedWriter* writer);
+    static void delist(StagedWriter* writer);
+
+    //--------------------------------------
+    // Files register here when they take their first record lock of an
+    // operation; commit() and abort() release them all at the end.
+    static void enlistLocks(StagedWriter* writer);
+    static void delistLocks(StagedWriter* writer);
+
+    //--------------------------------------
+    // Commits an implicit group, syncs every data file named in the log
+    // (by any process), then truncates the log. Runs automatically when
+    // the log grows large; refused while a Transaction is open.
+    static bool checkpoint();
+};
+
+//--------------------------------------
+// Class: Transaction
+// Scope guard around WriteAheadLog::begin(). Changes made through any
+// RecordFile while it is alive become durable together on commit();
+// if it goes out of scope uncommitted they are discarded.
+class Transaction {
+private:
+    bool active;
+
+public:
+    Transaction() : active(WriteAheadLog::begin()) {}
+    ~Transaction() { abort(); }
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    bool commit() {
+        if (!active) return false;
+        active = false;
+        return WriteAheadLog::commit();
+    }
+
+    void abort() {
+        if (!active) return;
+        active = false;
+        WriteAheadLog::abort();
+    }
+};
+
+#endif // WRITE_AHEAD_LOG_H
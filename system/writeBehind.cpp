@@ -0,0 +1,123 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// writeBehind.cpp
+// Purpose: Table registry and the background writer thread. A pass
+// holds the registry mutex while it walks the tables, so a table
+// cannot be withdrawn (and closed) under it; each table guards its own
+// records against the copy (see RecordFile<T>::writeBack()).
+//***************************************************
+
+#include "writeBehind.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    bool inMemory = false;
+    int intervalMs = WriteBehind::DEFAULT_INTERVAL_MS;
+
+    mutex tablesGuard;
+    vector<WriteBehindTable*> tables;
+
+    mutex wakeGuard;
+    condition_variable wake;
+    bool stopping = false;
+    thread writer;
+
+    //--------------------------------------
+    // Writer thread: one pass per interval until stopWriter()
+    void writerLoop() {
+        unique_lock<mutex> lock(wakeGuard);
+        while (!stopping) {
+            wake.wait_for(lock, chrono::milliseconds(intervalMs));
+            if (stopping) break;
+            lock.unlock();
+            WriteBehind::flushAll();
+            lock.lock();
+        }
+    }
+}
+
+//--------------------------------------
+void WriteBehind::setEnabled(bool on) {
+    inMemory = on;
+}
+
+//--------------------------------------
+bool WriteBehind::enabled() {
+    return inMemory;
+}
+
+//--------------------------------------
+void WriteBehind::setInterval(int milliseconds) {
+    intervalMs = (milliseconds < 1) ? 1 : milliseconds;
+}
+
+//--------------------------------------
+void WriteBehind::configureFromEnv() {
+    const char* env = getenv("SUPERFERRY_IN_MEMORY");
+    if (env != nullptr) {
+        string value = env;
+        if (value == "on" || value == "1")        setEnabled(true);
+        else if (value == "off" || value == "0")  setEnabled(false);
+        else cerr << "[WARN] Unknown SUPERFERRY_IN_MEMORY '" << value << "', keeping "
+                  << (inMemory ? "on" : "off") << "." << endl;
+    }
+
+    const char* interval = getenv("SUPERFERRY_WRITE_BEHIND_MS");
+    if (interval != nullptr) {
+        int ms = atoi(interval);
+        if (ms >= 1) setInterval(ms);
+        else cerr << "[WARN] Invalid SUPERFERRY_WRITE_BEHIND_MS '" << interval << "', keeping "
+                  << intervalMs << " ms." << endl;
+    }
+}
+
+//--------------------------------------
+void WriteBehind::enroll(WriteBehindTable* table) {
+    lock_guard<mutex> lock(tablesGuard);
+    if (find(tables.begin(), tables.end(), table) == tables.end()) tables.push_back(table);
+}
+
+//--------------------------------------
+void WriteBehind::withdraw(WriteBehindTable* table) {
+    lock_guard<mutex> lock(tablesGuard);
+    tables.erase(remove(tables.begin(), tables.end(), table), tables.end());
+}
+
+//--------------------------------------
+void WriteBehind::startWriter() {
+    if (!inMemory || writer.joinable()) return;
+    stopping = false;
+    writer = thread(writerLoop);
+}
+
+//--------------------------------------
+void WriteBehind::stopWriter() {
+    if (!writer.joinable()) return;
+    {
+        lock_guard<mutex> lock(wakeGuard);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+    flushAll();
+}
+
+//--------------------------------------
+bool WriteBehind::flushAll() {
+    lock_guard<mutex> lock(tablesGuard);
+    bool ok = true;
+    for (WriteBehindTable* table : tables) {
+        ok = table->writeBack(false) && ok;
+    }
+    return ok;
+}
@@ -0,0 +1,68 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// writeBehind.h
+// Purpose: In-memory mode. With SUPERFERRY_IN_MEMORY=on, every record
+// file is read into memory once when it opens (one pread) and from then
+// on served and changed there; the data file is only written by a
+// background writer, which copies the changed records back every
+// SUPERFERRY_WRITE_BEHIND_MS (default 200), and by a full snapshot when
+// the file closes at shutdown().
+//
+// Nothing committed is lost in between: each change is still in the
+// write-ahead log, checkpoint() writes the tables back before it syncs
+// the files and empties the log, and after a crash start() replays the
+// log onto the data files as usual.
+//
+// A process in this mode has the data files to itself: each is locked
+// exclusively while open. The lock is only tried, never waited for, so
+// a second process in this mode fails start() with "store in use by
+// another process" instead of hanging; one in the normal mode waits on
+// its record locks until the first exits.
+//***************************************************
+
+#ifndef WRITE_BEHIND_H
+#define WRITE_BEHIND_H
+
+//--------------------------------------
+// A table kept in memory (implemented by RecordFile<T>)
+class WriteBehindTable {
+public:
+    virtual ~WriteBehindTable() {}
+
+    //--------------------------------------
+    // Copies changed records to the data file and schedules them for
+    // disk. A snapshot writes the whole table and waits for the disk.
+    virtual bool writeBack(bool snapshot) = 0;
+};
+
+class WriteBehind {
+public:
+    static const int DEFAULT_INTERVAL_MS = 200;
+
+    //--------------------------------------
+    // Mode configuration, read by files as they open (handles already
+    // open keep their mode). configureFromEnv() reads
+    // SUPERFERRY_IN_MEMORY (on | off) and SUPERFERRY_WRITE_BEHIND_MS.
+    static void setEnabled(bool on);
+    static bool enabled();
+    static void setInterval(int milliseconds);
+    static void configureFromEnv();
+
+    //--------------------------------------
+    // Tables register while open; withdraw() waits out a pass in
+    // progress, so the table may be closed once it returns.
+    static void enroll(WriteBehindTable* table);
+    static void withdraw(WriteBehindTable* table);
+
+    //--------------------------------------
+    // Background writer. Both are no-ops when the mode is off or the
+    // writer is already in that state; stopWriter() runs a last pass.
+    static void startWriter();
+    static void stopWriter();
+
+    //--------------------------------------
+    // Writes every enrolled table back now (used by checkpoint()).
+    static bool flushAll();
+};
+
+#endif // WRITE_BEHIND_H
@@ -0,0 +1,201 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// boothClient.cpp
+// Purpose: Booth menu and one-shot requests against `superferry serve`.
+// Prompts and prints only; every check and change happens on the
+// server.
+//***************************************************
+
+#include "boothClient.h"
+#include "../system/socketChannel.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+using namespace std;
+
+namespace {
+    //--------------------------------------
+    // Prompts until a non-empty line is typed. False at end of input.
+    bool ask(const string& prompt, string& answer) {
+        while (true) {
+            cout << "> " << prompt << " : ";
+            if (!getline(cin, answer)) return false;
+            size_t first = answer.find_first_not_of(" \t\r");
+            if (first == string::npos) continue;
+            size_t last = answer.find_last_not_of(" \t\r");
+            answer = answer.substr(first, last - first + 1);
+            return true;
+        }
+    }
+
+    //--------------------------------------
+    // Sends a request; prints the reason and returns false on "ERR" or
+    // a lost connection.
+    bool submit(SocketChannel& server, const vector<string>& request,
+              vector<string>& status, vector<string>* rows = nullptr) {
+        string line;
+        if (!server.request(request, line, rows)) {
+            cout << "[ERROR] Lost connection to the server." << endl;
+            status.clear();
+            return false;
+        }
+        status = wireFields(line);
+        if (status[0] != "OK") {
+            cout << "Error: " << (status.size() > 1 ? status[1] : line) << endl;
+            return false;
+        }
+        return true;
+    }
+
+    //--------------------------------------
+    void bookFlow(SocketChannel& server) {
+        string height, length, plate, phone, sailing;
+        if (!ask("Enter Vehicle Height in m (2.0 or less for regular)", height) ||
+            !ask("Enter Vehicle Length in m (7.0 or less for regular)", length)) return;
+
+        vector<string> status, rows;
+        if (!submit(server, { "MATCH", height, length }, status, &rows)) return;
+        if (rows.empty()) {
+            cout << "No sailing has room for this vehicle." << endl;
+            return;
+        }
+
+        cout << "\n     Sailing     Ferry                       HRL     LRL" << endl;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            vector<string> r = wireFields(rows[i]);
+            if (r.size() < 4) continue;
+            cout << right << setw(4) << (i + 1) << " " << left << setw(12) << r[0]
+                 << setw(28) << r[1] << setw(8) << r[2] << r[3] << endl;
+        }
+
+        string choice;
+        if (!ask("Select a sailing [1 - " + to_string(rows.size()) + "] or type a sailing ID", choice)) return;
+        int pick = atoi(choice.c_str());
+        if (pick >= 1 && pick <= static_cast<int>(rows.size()) && choice.find('-') == string::npos) {
+            sailing = wireFields(rows[pick - 1])[0];
+        } else {
+            sailing = choice;
+        }
+
+        if (!ask("Enter License Plate", plate) || !ask("Enter Phone Number", phone)) return;
+
+        if (submit(server, { "BOOK", plate, phone, height, length, sailing }, status)) {
+            cout << "Reservation Confirmed: " << plate << " on " << sailing
+                 << " (lane " << status[1] << "), fare $" << status[2] << endl;
+        }
+    }
+
+    //--------------------------------------
+    void checkInFlow(SocketChannel& server) {
+        string plate, sailing;
+        if (!ask("Enter License Plate", plate) || !ask("Enter Sailing ID (TTT-DD-HH)", sailing)) return;
+
+        vector<string> status;
+        if (submit(server, { "CHECKIN", plate, sailing }, status)) {
+            cout << "Vehicle " << plate << " checked in. Fare due: $" << status[1] << endl;
+        }
+    }
+
+    //--------------------------------------
+    void cancelFlow(SocketChannel& server) {
+        string plate;
+        if (!ask("Enter License Plate", plate)) return;
+
+        vector<string> status, rows;
+        if (!submit(server, { "FIND", plate }, status, &rows)) return;
+        if (rows.empty()) {
+            cout << "No reservations found for " << plate << "." << endl;
+            return;
+        }
+
+        for (size_t i = 0; i < rows.size(); ++i) {
+            vector<string> r = wireFields(rows[i]);
+            cout << "[" << (i + 1) << "] " << r[0] << (r.size() > 1 && r[1] == "1" ? "  (onboard)" : "") << endl;
+        }
+        string choice;
+        if (!ask("Select a reservation [1 - " + to_string(rows.size()) + "] or q to cancel", choice)) return;
+        int pick = atoi(choice.c_str());
+        if (pick < 1 || pick > static_cast<int>(rows.size())) return;
+
+        string sailing = wireFields(rows[pick - 1])[0];
+        if (submit(server, { "CANCEL", plate, sailing }, status)) {
+            cout << "Reservation deleted successfully." << endl;
+            if (status[1] != "-") cout << "Freed sailing lane space (lane " << status[1] << ")" << endl;
+        }
+    }
+
+    //--------------------------------------
+    void reportFlow(SocketChannel& server) {
+        vector<string> status, rows;
+        if (!submit(server, { "REPORT" }, status, &rows)) return;
+
+        cout << "\n   #  Sailing     Ferry                       HRL     LRL     Onboard" << endl;
+        for (const string& row : rows) cout << row << endl;
+        cout << status[1] << " sailing(s)." << endl;
+    }
+
+    //--------------------------------------
+    void boothMenu(SocketChannel& server) {
+        while (server.isOpen()) {
+            cout << "\n-------------------------- Booth Menu --------------------------\n"
+                 << "[1] Create New Reservation\n"
+                 << "[2] Check-in Vehicle\n"
+                 << "[3] Delete Confirmed Reservation\n"
+                 << "[4] Print Sailing Report\n"
+                 << "[5] Exit" << endl;
+
+            string option;
+            if (!ask("Select [1 - 5]", option)) break;
+
+            if (option == "1")      bookFlow(server);
+            else if (option == "2") checkInFlow(server);
+            else if (option == "3") cancelFlow(server);
+            else if (option == "4") reportFlow(server);
+            else if (option == "5") break;
+            else cout << "Invalid option. Please select a valid menu option [1 - 5]." << endl;
+        }
+
+        string ignored;
+        server.request({ "QUIT" }, ignored);
+        cout << "Program Exited. Goodbye!" << endl;
+    }
+}
+
+//--------------------------------------
+int runClient(int argc, char* argv[]) {
+    string path = DEFAULT_SOCKET_PATH;
+    int first = 2;
+    if (argc > 3 && strcmp(argv[2], "--socket") == 0) {
+        path = argv[3];
+        first = 4;
+    }
+
+    SocketChannel server;
+    if (!server.connectTo(path)) {
+        cerr << "[ERROR] No server listening on " << path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    if (first >= argc) {
+        boothMenu(server);
+        return 0;
+    }
+
+    // one-shot: print the reply as it came
+    vector<string> request(argv + first, argv + argc);
+    string status;
+    vector<string> rows;
+    if (!server.request(request, status, &rows)) {
+        cerr << "[ERROR] Lost connection to the server." << endl;
+        return 1;
+    }
+    cout << status << endl;
+    for (const string& row : rows) cout << row << endl;
+    return status.compare(0, 2, "OK") == 0 ? 0 : 1;
+}
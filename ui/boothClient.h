@@ -0,0 +1,26 @@
+//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//***************************************************
+// boothClient.h
+// Purpose: Terminal client of `superferry serve` for the ticket and
+// check-in booths. Offers the booth subset of the main menu (book,
+// check in, cancel, sailing report) and sends each action to the
+// server, so many booths can work on one data set at once.
+//***************************************************
+
+#ifndef BOOTH_CLIENT_H
+#define BOOTH_CLIENT_H
+
+//--------------------------------------
+// Function: runClient
+// in : argc/argv - argv[1] is "client"; options follow
+// out: int - process exit code
+// Purpose : Usage:
+//             superferry client [--socket PATH]
+//             superferry client [--socket PATH] VERB [FIELD ...]
+//           The first form runs the booth menu; the second sends one
+//           request (see reservationServer.h) and prints the reply,
+//           exiting 0 if the server answered OK and 1 otherwise.
+//--------------------------------------
+int runClient(int argc, char* argv[]);
+
+#endif // BOOTH_CLIENT_H
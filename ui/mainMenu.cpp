@@ -15,11 +15,14 @@
 #include <iostream>
 #include <cstring>
 #include <iomanip>
+#include <limits>
 #include "../system/utilities.h"
 
 #include "../control/ferryManager.h"
 #include "../control/reservationManager.h"
+#include "../control/reservationService.h"
 #include "../control/sailingManager.h"
+#include "../entity/storeRegistry.h"
 
 using namespace std;
 
@@ -34,8 +37,9 @@ using namespace std;
 
 bool displayMainMenu(){
 
-    static ReservationManager rm;
     static SailingManager sm;
+    static ReservationService service(sm);
+    static ReservationManager rm(service);
     static bool initialized = false;
 
     if (!initialized) {
@@ -73,19 +77,23 @@ bool displayMainMenu(){
         cout << "[6] Delete Confirmed Reservation" << endl;
         cout << "[7] Reset System" << endl;
         cout << "[8] Exit System" << endl;
+        cout << "[9] Diagnostics" << endl;
     
         cout << setw(width) << "\n" << endl;
     
-        cout << "> Select [1 - 8]: ";
+        cout << "> Select [1 - 9]: ";
     
         while (option < 1 || option > 9) {
             cin >> option;
             if (cin.fail() || option < 1 || option > 9) {
                 cin.clear();
                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                cout << "Invalid option. Please select a valid menu option [1 - 8]: ";
+                cout << "Invalid option. Please select a valid menu option [1 - 9]: ";
             }
         }
+
+        // a data file restored over ours meanwhile is picked up here
+        StoreRegistry::revalidate();
     
         switch (option) {
             case 1:
@@ -107,7 +115,7 @@ bool displayMainMenu(){
                 }
     
                 if (option == 1) {
-                    createFerry();
+                    createFerry(service);
                     option = -1;
                     while (option != 1 && option != 2) {
                         cin.clear();
@@ -122,12 +130,12 @@ bool displayMainMenu(){
                     }
                     if (option == 1) {
                         cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        createFerry();
+                        createFerry(service);
                         option = -1;
                     } else if (option == 2) break;
 
                 } else if (option == 2) {
-                    if (!deleteFerry()) {
+                    if (!deleteFerry(service)) {
                         cout << "Could not delete the ferry. Please try again." << endl;
                         break;
                     }
@@ -143,7 +151,7 @@ bool displayMainMenu(){
                         }
                         if (option == 1) {
                             cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                            deleteFerry();
+                            deleteFerry(service);
                             option = -1;
                         } else if (option == 2) break;
                     }
@@ -178,7 +186,7 @@ bool displayMainMenu(){
                 
                 break;
             case 6:
-                rm.deleteFlow(sm);
+                rm.deleteFlow();
                 
                 break;
             case 7:
@@ -192,6 +200,9 @@ bool displayMainMenu(){
                 cout << "Program Exited. Goodbye!" << endl;
                 showMenu = false;
                 break;
+            case 9:
+                printDiagnostics(cout);
+                break;
         }
 
     }